@@ -0,0 +1,487 @@
+/***************************************************************************
+                          ofx_generator.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Deterministic generator of synthetic OFX, QFX and OFC files
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <stdio.h>
+#include <time.h>
+#include "ofx_generator.hh"
+
+/** Payees, in UTF-8, some of them with characters outside of ASCII */
+static const char *PAYEES[] =
+{
+  "ACME GROCERY #1532",
+  "Caf\xc3\xa9 M\xc3\xbcller",
+  "CITY WATER DEPT",
+  "Boulangerie Cr\xc3\xa8me Br\xc3\xbbl\xc3\xa9" "e",
+  "ONLINE PAYMENT - THANK YOU",
+  "Se\xc3\xb1or Taco",
+  "PAYROLL DEPOSIT",
+  "Hardware Store",
+  "ATM WITHDRAWAL 0042",
+  "\xc3\x85ngstr\xc3\xb6m Books",
+  NULL
+};
+
+static const char *MEMOS[] =
+{
+  "POS PURCHASE",
+  "Recurring payment",
+  "Transfer from savings",
+  "Frais de tenue de compte",
+  "ELECTRONIC DEPOSIT",
+  NULL
+};
+
+static const char *TRNTYPES[] =
+{
+  "DEBIT", "CREDIT", "POS", "ATM", "CHECK", "PAYMENT", "XFER", "DEP", "FEE", NULL
+};
+
+/** xorshift64*: the same sequence everywhere, unlike rand() */
+class Random
+{
+public:
+  Random(unsigned long seed)
+    : state(seed * 2654435761ULL + 0x9E3779B97F4A7C15ULL)
+  {
+  };
+  unsigned long long next()
+  {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+  };
+  /** Uniform integer in [0, n) */
+  unsigned int below(unsigned int n)
+  {
+    return (unsigned int)(next() >> 33) % n;
+  };
+  /** true with the given probability */
+  bool chance(double probability)
+  {
+    return (next() >> 11) * (1.0 / 9007199254740992.0) < probability;
+  };
+private:
+  unsigned long long state;
+};
+
+static int count(const char **list)
+{
+  int i = 0;
+  while (list[i] != NULL)
+    i++;
+  return i;
+}
+
+/** Writes the elements in the style requested, and the text in the requested encoding */
+class Writer
+{
+public:
+  Writer(const OfxGenOptions &p_options, ostream &p_out)
+    : options(p_options)
+    , out(p_out)
+    , eol(p_options.crlf ? "\r\n" : "\n")
+  {
+  };
+
+  void line(const string &s)
+  {
+    out << s << eol;
+  };
+
+  void open(const char *tag)
+  {
+    out << '<' << tag << '>';
+    end_tag_line();
+  };
+
+  void close(const char *tag)
+  {
+    out << "</" << tag << '>';
+    end_tag_line();
+  };
+
+  void data(const char *tag, const string &value)
+  {
+    out << '<' << tag << '>' << encode(value);
+    if (options.format == OfxGenOptions::OFX2)
+      out << "</" << tag << '>';
+    end_tag_line();
+  };
+
+  /** Ends the single line of a minified body */
+  void finish()
+  {
+    if (options.minified)
+      out << eol;
+  };
+
+private:
+  void end_tag_line()
+  {
+    if (!options.minified)
+      out << eol;
+  };
+
+  /** UTF-8 to the encoding of the file; the payees only use Latin-1 characters */
+  string encode(const string &utf8)
+  {
+    if (options.encoding == OfxGenOptions::UTF8)
+      return utf8;
+    string result;
+    for (string::size_type i = 0; i < utf8.size(); i++)
+    {
+      unsigned char c = utf8[i];
+      if (c >= 0xC0 && i + 1 < utf8.size())
+      {
+        result += (char)(((c & 0x1F) << 6) | (utf8[i+1] & 0x3F));
+        i++;
+      }
+      else
+      {
+        result += (char)c;
+      }
+    }
+    return result;
+  };
+
+  const OfxGenOptions &options;
+  ostream &out;
+  const char *eol;
+};
+
+/** An OFX date for the nth day after 2019-01-01, in one of the styles found in the wild */
+static string ofx_date(Random &random, int day, bool with_time)
+{
+  time_t t = 1546300800 + (time_t)day * 86400 + random.below(86400);
+  struct tm *tm = gmtime(&t);
+  char buffer[64];
+  if (!with_time)
+  {
+    strftime(buffer, sizeof(buffer), "%Y%m%d", tm);
+    return buffer;
+  }
+  switch (random.below(4))
+  {
+  case 0:
+    strftime(buffer, sizeof(buffer), "%Y%m%d", tm);
+    break;
+  case 1:
+    strftime(buffer, sizeof(buffer), "%Y%m%d%H%M%S", tm);
+    break;
+  case 2:
+    strftime(buffer, sizeof(buffer), "%Y%m%d%H%M%S.000[-5:EST]", tm);
+    break;
+  default:
+    strftime(buffer, sizeof(buffer), "%Y%m%d120000[0:GMT]", tm);
+  }
+  return buffer;
+}
+
+static string amount(long long cents)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%s%lld.%02lld", cents < 0 ? "-" : "",
+           (cents < 0 ? -cents : cents) / 100, (cents < 0 ? -cents : cents) % 100);
+  return buffer;
+}
+
+static string number(long long n)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%lld", n);
+  return buffer;
+}
+
+static void write_header(const OfxGenOptions &options, Writer &w)
+{
+  if (options.format == OfxGenOptions::OFX2)
+  {
+    w.line(string("<?xml version=\"1.0\" encoding=\"") +
+           (options.encoding == OfxGenOptions::UTF8 ? "UTF-8" :
+            options.encoding == OfxGenOptions::LATIN1 ? "ISO-8859-1" : "windows-1252") +
+           "\" standalone=\"no\"?>");
+    w.line("<?OFX OFXHEADER=\"200\" VERSION=\"211\" SECURITY=\"NONE\" OLDFILEUID=\"NONE\" NEWFILEUID=\"NONE\"?>");
+    return;
+  }
+  bool ofc = options.format == OfxGenOptions::OFC;
+  w.line(ofc ? "OFCHEADER:100" : "OFXHEADER:100");
+  w.line(ofc ? "DATA:OFCSGML" : "DATA:OFXSGML");
+  w.line("VERSION:102");
+  w.line(ofc ? "SECURITY:TYPE1" : "SECURITY:NONE");
+  switch (options.encoding)
+  {
+  case OfxGenOptions::UTF8:
+    w.line("ENCODING:UTF-8");
+    w.line("CHARSET:NONE");
+    break;
+  case OfxGenOptions::LATIN1:
+    w.line("ENCODING:USASCII");
+    w.line("CHARSET:ISO-8859-1");
+    break;
+  default:
+    w.line("ENCODING:USASCII");
+    w.line("CHARSET:1252");
+  }
+  w.line("COMPRESSION:NONE");
+  w.line("OLDFILEUID:NONE");
+  w.line("NEWFILEUID:NONE");
+  w.line("");
+}
+
+static void write_status(Writer &w)
+{
+  w.open("STATUS");
+  w.data("CODE", "0");
+  w.data("SEVERITY", "INFO");
+  w.close("STATUS");
+}
+
+static void write_bank_statement(const OfxGenOptions &options, Writer &w, Random &random, int account)
+{
+  int days = options.transactions / 20 + 1;
+  long long balance = 0;
+
+  w.open("STMTTRNRS");
+  w.data("TRNUID", number(1000 + account));
+  write_status(w);
+  w.open("STMTRS");
+  w.data("CURDEF", "USD");
+  w.open("BANKACCTFROM");
+  w.data("BANKID", "121099999");
+  w.data("ACCTID", number(100000 + account));
+  w.data("ACCTTYPE", account % 2 ? "SAVINGS" : "CHECKING");
+  w.close("BANKACCTFROM");
+  w.open("BANKTRANLIST");
+  w.data("DTSTART", ofx_date(random, 0, true));
+  w.data("DTEND", ofx_date(random, days, true));
+  for (int i = 0; i < options.transactions; i++)
+  {
+    long long cents = (long long)random.below(1000000) - 500000;
+    balance += cents;
+    w.open("STMTTRN");
+    w.data("TRNTYPE", TRNTYPES[random.below(count(TRNTYPES))]);
+    w.data("DTPOSTED", ofx_date(random, i / 20, true));
+    w.data("TRNAMT", amount(cents));
+    w.data("FITID", number(account) + "-" + number(i));
+    if (random.below(10) == 0)
+      w.data("CHECKNUM", number(1000 + i));
+    w.data("NAME", PAYEES[random.below(count(PAYEES))]);
+    if (random.below(2) == 0)
+      w.data("MEMO", MEMOS[random.below(count(MEMOS))]);
+    if (options.proprietary > 0 && random.chance(options.proprietary))
+      w.data("INTU.XFER", number(random.below(100000)));
+    w.close("STMTTRN");
+  }
+  w.close("BANKTRANLIST");
+  w.open("LEDGERBAL");
+  w.data("BALAMT", amount(balance));
+  w.data("DTASOF", ofx_date(random, days, true));
+  w.close("LEDGERBAL");
+  w.open("AVAILBAL");
+  w.data("BALAMT", amount(balance));
+  w.data("DTASOF", ofx_date(random, days, true));
+  w.close("AVAILBAL");
+  w.close("STMTRS");
+  w.close("STMTTRNRS");
+}
+
+static void write_secid(Writer &w, int security)
+{
+  char cusip[16];
+  snprintf(cusip, sizeof(cusip), "%09d", 100000000 + security * 7919);
+  w.open("SECID");
+  w.data("UNIQUEID", cusip);
+  w.data("UNIQUEIDTYPE", "CUSIP");
+  w.close("SECID");
+}
+
+static void write_investment_statement(const OfxGenOptions &options, Writer &w, Random &random)
+{
+  int days = options.transactions / 20 + 1;
+
+  w.open("INVSTMTMSGSRSV1");
+  w.open("INVSTMTTRNRS");
+  w.data("TRNUID", "2000");
+  write_status(w);
+  w.open("INVSTMTRS");
+  w.data("DTASOF", ofx_date(random, days, true));
+  w.data("CURDEF", "USD");
+  w.open("INVACCTFROM");
+  w.data("BROKERID", "broker.example.com");
+  w.data("ACCTID", "900000");
+  w.close("INVACCTFROM");
+  w.open("INVTRANLIST");
+  w.data("DTSTART", ofx_date(random, 0, true));
+  w.data("DTEND", ofx_date(random, days, true));
+  for (int i = 0; i < options.transactions; i++)
+  {
+    bool buy = random.below(2) == 0;
+    long long units = random.below(500) + 1;
+    long long price_cents = random.below(50000) + 100;
+    long long commission_cents = random.below(1000);
+    long long total = units * price_cents + (buy ? commission_cents : -commission_cents);
+
+    w.open(buy ? "BUYSTOCK" : "SELLSTOCK");
+    w.open(buy ? "INVBUY" : "INVSELL");
+    w.open("INVTRAN");
+    w.data("FITID", "inv-" + number(i));
+    w.data("DTTRADE", ofx_date(random, i / 20, true));
+    w.data("MEMO", MEMOS[random.below(count(MEMOS))]);
+    w.close("INVTRAN");
+    write_secid(w, random.below(options.securities));
+    w.data("UNITS", number(buy ? units : -units));
+    w.data("UNITPRICE", amount(price_cents));
+    w.data("COMMISSION", amount(commission_cents));
+    w.data("TOTAL", amount(buy ? -total : total));
+    w.data("SUBACCTSEC", "CASH");
+    w.data("SUBACCTFUND", "CASH");
+    w.close(buy ? "INVBUY" : "INVSELL");
+    w.data(buy ? "BUYTYPE" : "SELLTYPE", buy ? "BUY" : "SELL");
+    if (options.proprietary > 0 && random.chance(options.proprietary))
+      w.data("INTU.LOTID", number(random.below(100000)));
+    w.close(buy ? "BUYSTOCK" : "SELLSTOCK");
+  }
+  w.close("INVTRANLIST");
+  w.close("INVSTMTRS");
+  w.close("INVSTMTTRNRS");
+  w.close("INVSTMTMSGSRSV1");
+
+  w.open("SECLISTMSGSRSV1");
+  w.open("SECLIST");
+  for (int s = 0; s < options.securities; s++)
+  {
+    char ticker[16];
+    snprintf(ticker, sizeof(ticker), "T%04d", s);
+    w.open("STOCKINFO");
+    w.open("SECINFO");
+    write_secid(w, s);
+    w.data("SECNAME", string("Synthetic Security ") + ticker);
+    w.data("TICKER", ticker);
+    w.close("SECINFO");
+    w.close("STOCKINFO");
+  }
+  w.close("SECLIST");
+  w.close("SECLISTMSGSRSV1");
+}
+
+static void write_ofx(const OfxGenOptions &options, Writer &w, Random &random)
+{
+  w.open("OFX");
+  w.open("SIGNONMSGSRSV1");
+  w.open("SONRS");
+  write_status(w);
+  w.data("DTSERVER", ofx_date(random, 0, true));
+  w.data("LANGUAGE", "ENG");
+  if (options.proprietary > 0)
+    w.data("INTU.BID", "3000");
+  w.close("SONRS");
+  w.close("SIGNONMSGSRSV1");
+  if (options.accounts > 0)
+  {
+    w.open("BANKMSGSRSV1");
+    for (int a = 0; a < options.accounts; a++)
+      write_bank_statement(options, w, random, a);
+    w.close("BANKMSGSRSV1");
+  }
+  if (options.securities > 0)
+    write_investment_statement(options, w, random);
+  w.close("OFX");
+}
+
+static void write_ofc(const OfxGenOptions &options, Writer &w, Random &random)
+{
+  int days = options.transactions / 20 + 1;
+
+  w.open("OFC");
+  w.data("DTD", "2");
+  w.data("CPAGE", "1252");
+  for (int a = 0; a < options.accounts; a++)
+  {
+    long long balance = 0;
+    w.open("ACCTSTMT");
+    w.open("ACCTFROM");
+    w.open("ACCOUNT");
+    w.data("BANKID", "121099999");
+    w.data("ACCTID", number(100000 + a));
+    w.data("ACCTTYPE", a % 2 ? "1" : "0");
+    w.close("ACCOUNT");
+    w.close("ACCTFROM");
+    w.open("STMTRS");
+    w.data("DTSTART", ofx_date(random, 0, false));
+    w.data("DTEND", ofx_date(random, days, false));
+    w.data("LEDGER", "0.00");
+    for (int i = 0; i < options.transactions; i++)
+    {
+      long long cents = (long long)random.below(1000000) - 500000;
+      balance += cents;
+      w.open("STMTTRN");
+      w.open("GENTRN");
+      w.data("TRNTYPE", cents < 0 ? "1" : "0");
+      w.data("DTPOSTED", ofx_date(random, i / 20, false));
+      w.data("TRNAMT", amount(cents));
+      w.data("FITID", number(a) + "-" + number(i));
+      w.data("NAME", PAYEES[random.below(count(PAYEES))]);
+      if (random.below(2) == 0)
+        w.data("MEMO", MEMOS[random.below(count(MEMOS))]);
+      if (options.proprietary > 0 && random.chance(options.proprietary))
+        w.data("INTU.XFER", number(random.below(100000)));
+      w.close("GENTRN");
+      w.close("STMTTRN");
+    }
+    w.close("STMTRS");
+    w.close("ACCTSTMT");
+  }
+  w.close("OFC");
+}
+
+bool ofxgen_parse_format(const string &name, OfxGenOptions::Format &format)
+{
+  if (name == "ofx1" || name == "ofx" || name == "qfx")
+    format = OfxGenOptions::OFX1;
+  else if (name == "ofx2" || name == "xml")
+    format = OfxGenOptions::OFX2;
+  else if (name == "ofc")
+    format = OfxGenOptions::OFC;
+  else
+    return false;
+  return true;
+}
+
+bool ofxgen_parse_encoding(const string &name, OfxGenOptions::Encoding &encoding)
+{
+  if (name == "cp1252" || name == "1252")
+    encoding = OfxGenOptions::CP1252;
+  else if (name == "latin1" || name == "iso-8859-1")
+    encoding = OfxGenOptions::LATIN1;
+  else if (name == "utf8" || name == "utf-8")
+    encoding = OfxGenOptions::UTF8;
+  else
+    return false;
+  return true;
+}
+
+void ofxgen_generate(const OfxGenOptions &options, ostream &out)
+{
+  Random random(options.seed);
+  Writer w(options, out);
+
+  write_header(options, w);
+  if (options.format == OfxGenOptions::OFC)
+    write_ofc(options, w, random);
+  else
+    write_ofx(options, w, random);
+  w.finish();
+}
@@ -0,0 +1,74 @@
+/***************************************************************************
+                          ofx_generator.hh
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Deterministic generator of synthetic OFX, QFX and OFC files
+ *
+ * Used by ofxgen and the benchmarks.  The same options and seed always
+ * produce the same file.
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef OFX_GENERATOR_H
+#define OFX_GENERATOR_H
+
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+struct OfxGenOptions
+{
+  enum Format
+  {
+    OFX1, /**< OFX 1.02 SGML */
+    OFX2, /**< OFX 2.1.1 XML */
+    OFC   /**< Microsoft OFC */
+  };
+  enum Encoding
+  {
+    CP1252,  /**< ENCODING:USASCII, CHARSET:1252 */
+    LATIN1,  /**< ENCODING:USASCII, CHARSET:ISO-8859-1 */
+    UTF8     /**< ENCODING:UTF-8 */
+  };
+
+  Format format;
+  Encoding encoding;
+  int accounts; /**< Bank accounts */
+  int transactions; /**< Transactions per account */
+  int securities; /**< If not 0, an investment account trading these securities is added (not for OFC) */
+  double proprietary; /**< Fraction of the transactions carrying a proprietary (INTU.*) tag */
+  bool minified; /**< Whole body on a single line, instead of one tag per line */
+  bool crlf; /**< DOS line endings */
+  unsigned long seed;
+
+  OfxGenOptions()
+    : format(OFX1)
+    , encoding(CP1252)
+    , accounts(1)
+    , transactions(1000)
+    , securities(0)
+    , proprietary(0)
+    , minified(false)
+    , crlf(false)
+    , seed(1)
+  {
+  };
+};
+
+/** Parse a format name: "ofx1" (or "qfx"), "ofx2" or "ofc"; returns false if unknown */
+bool ofxgen_parse_format(const string &name, OfxGenOptions::Format &format);
+/** Parse an encoding name: "cp1252", "latin1" or "utf8"; returns false if unknown */
+bool ofxgen_parse_encoding(const string &name, OfxGenOptions::Encoding &encoding);
+
+/** Write a file according to options */
+void ofxgen_generate(const OfxGenOptions &options, ostream &out);
+
+#endif
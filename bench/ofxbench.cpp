@@ -0,0 +1,186 @@
+/***************************************************************************
+                          ofxbench.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Code for the ofxbench benchmark utility
+ *
+ * ofxbench parses files with libofx_proc_file() several times and reports
+ * the throughput in MB/s and transactions/s, and the peak resident set
+ * size of the process.  Run it once per file to get the peak RSS of each
+ * file, as it is a high water mark.
+ *
+ * With --threads, the statements of each file are parsed on that many
+ * threads, see libofx_set_worker_threads().  With --pipelined, the
+ * callbacks run while the file is parsed, see
+ * libofx_set_pipelined_callbacks(); --callback-us makes the transaction
+ * callback busy for that many microseconds, as an application storing
+ * the transactions would be.
+ *
+ * usage: ofxbench [--repeat=N] [--threads=N] [--pipelined] [--callback-us=N] [--dtd-dir=DIR] [--phases] [--csv] [--no-header] files...
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include "libofx.h"
+
+using namespace std;
+
+/** Time the transaction callback spends working, in microseconds */
+static int callback_us = 0;
+
+static int transaction_cb(const struct OfxTransactionData, void *count)
+{
+  (*(unsigned long *)count)++;
+  if (callback_us > 0)
+  {
+    chrono::steady_clock::time_point end = chrono::steady_clock::now() + chrono::microseconds(callback_us);
+    while (chrono::steady_clock::now() < end)
+      ;
+  }
+  return 0;
+}
+
+/** Peak resident set size of the process, in bytes; 0 if unknown */
+static double peak_rss()
+{
+#ifdef _WIN32
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#ifdef __APPLE__
+  return usage.ru_maxrss;
+#else
+  return usage.ru_maxrss * 1024.0;
+#endif
+#endif
+}
+
+static double now()
+{
+  return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void print_phases(const struct LibofxStats &stats)
+{
+  printf("    detection %.3fs, headers %.3fs, iconv %.3fs, sanitize %.3fs, dtd %.3fs,\n"
+         "    opensp %.3fs, containers %.3fs, callbacks %.3fs\n"
+         "    %llu elements, %llu data elements, %llu dummy containers, %llu containers allocated\n"
+         "    %llu dates from the date cache, %llu converted\n",
+         stats.file_detection_ns * 1e-9, stats.header_parsing_ns * 1e-9,
+         stats.iconv_ns * 1e-9, stats.sanitize_ns * 1e-9, stats.dtd_ns * 1e-9,
+         stats.sgml_parsing_ns * 1e-9, stats.container_ns * 1e-9, stats.callback_ns * 1e-9,
+         stats.elements, stats.data_elements, stats.dummy_containers, stats.allocations,
+         stats.date_cache_hits, stats.date_cache_misses);
+}
+
+int main(int argc, char *argv[])
+{
+  int repeat = 3;
+  int threads = 1;
+  bool pipelined = false;
+  const char *dtd_dir = NULL;
+  bool phases = false;
+  bool csv = false;
+  bool header = true;
+  vector<const char *> files;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "--repeat=", 9) == 0)
+      repeat = max(1, atoi(argv[i] + 9));
+    else if (strncmp(argv[i], "--threads=", 10) == 0)
+      threads = max(1, atoi(argv[i] + 10));
+    else if (strcmp(argv[i], "--pipelined") == 0)
+      pipelined = true;
+    else if (strncmp(argv[i], "--callback-us=", 14) == 0)
+      callback_us = max(0, atoi(argv[i] + 14));
+    else if (strncmp(argv[i], "--dtd-dir=", 10) == 0)
+      dtd_dir = argv[i] + 10;
+    else if (strcmp(argv[i], "--phases") == 0)
+      phases = true;
+    else if (strcmp(argv[i], "--csv") == 0)
+      csv = true;
+    else if (strcmp(argv[i], "--no-header") == 0)
+      header = false;
+    else if (argv[i][0] == '-')
+    {
+      fprintf(stderr, "usage: %s [--repeat=N] [--threads=N] [--pipelined] [--callback-us=N] [--dtd-dir=DIR] [--phases] [--csv] [--no-header] files...\n", argv[0]);
+      return 1;
+    }
+    else
+      files.push_back(argv[i]);
+  }
+  if (files.empty())
+  {
+    fprintf(stderr, "%s: no input file\n", argv[0]);
+    return 1;
+  }
+
+  if (header && csv)
+    printf("file,bytes,runs,best_s,median_s,mb_per_s,transactions,transactions_per_s,peak_rss_bytes\n");
+  else if (header)
+    printf("%-32s %9s %5s %9s %9s %9s %12s %10s\n",
+           "file", "MB", "runs", "best s", "median s", "MB/s", "tx/s", "peak RSS MB");
+
+  for (size_t f = 0; f < files.size(); f++)
+  {
+    struct stat st;
+    if (stat(files[f], &st) != 0)
+    {
+      fprintf(stderr, "%s: unable to stat %s\n", argv[0], files[f]);
+      return 1;
+    }
+    double mb = st.st_size / 1e6;
+
+    vector<double> times;
+    unsigned long transactions = 0;
+    struct LibofxStats stats;
+    for (int r = 0; r < repeat; r++)
+    {
+      LibofxContextPtr ctx = libofx_get_new_context();
+      if (dtd_dir != NULL)
+        libofx_set_dtd_dir(ctx, dtd_dir);
+      libofx_set_worker_threads(ctx, threads);
+      libofx_set_pipelined_callbacks(ctx, pipelined);
+      transactions = 0;
+      ofx_set_transaction_cb(ctx, transaction_cb, &transactions);
+      double start = now();
+      libofx_proc_file(ctx, files[f], AUTODETECT);
+      times.push_back(now() - start);
+      libofx_get_stats(ctx, &stats);
+      libofx_free_context(ctx);
+    }
+    sort(times.begin(), times.end());
+    double best = times[0];
+    double median = times[times.size() / 2];
+
+    if (csv)
+      printf("%s,%lld,%d,%.6f,%.6f,%.3f,%lu,%.1f,%.0f\n", files[f], (long long)st.st_size,
+             repeat, best, median, mb / best, transactions, transactions / best, peak_rss());
+    else
+      printf("%-32s %9.2f %5d %9.4f %9.4f %9.2f %12.0f %10.1f\n", files[f], mb,
+             repeat, best, median, mb / best, transactions / best, peak_rss() / 1e6);
+    if (phases && !csv)
+      print_phases(stats);
+  }
+  return 0;
+}
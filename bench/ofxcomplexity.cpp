@@ -0,0 +1,239 @@
+/***************************************************************************
+                          ofxcomplexity.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Complexity check of the code paths that unusual input can make slow
+ *
+ * ofxcomplexity runs each case at 1, 2, 4 and 8 times a base size, and
+ * estimates the exponent k of the running time, n^k, from the smallest and
+ * the largest size.  It exits with a non zero status if k is above
+ * --max-exponent (default 1.3) for any case: 1 is linear, 2 quadratic.
+ *
+ * The cases are:
+ * - sanitize_proprietary_tags() on lines made of proprietary tags, each
+ *   of which is erased from the line;
+ * - strip_whitespace() on long values mixing spaces, tabs and newlines;
+ * - parsing a statement with many transactions in one account, which
+ *   looks up the last account on each insert;
+ * - parsing a file with many accounts, which walks to the last sibling
+ *   account on each insert;
+ * - parsing an investment statement trading many securities, which looks
+ *   up the security of each transaction;
+ * - parsing a QFX file where every transaction carries a proprietary tag.
+ *
+ * usage: ofxcomplexity [--scale=F] [--repeat=N] [--max-exponent=K] [--dtd-dir=DIR] [filter]
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include "ParserEventGeneratorKit.h"
+#include "libofx.h"
+#include "ofx_utilities.hh"
+#include "ofx_preproc.hh"
+#include "ofx_generator.hh"
+
+using namespace std;
+
+/** Keeps results alive, so that the compiler can't drop the calls */
+static volatile double sink;
+
+static const char *dtd_dir = NULL;
+
+static double now()
+{
+  return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** Prepares the input of size n, and returns the time to process it */
+typedef double (*CaseFunction)(long n);
+
+/* ---------------- Functions ---------------- */
+
+/** Number of calls per measurement of the functions on short lines */
+static const int LINE_CALLS = 2000;
+
+static double case_sanitize(long n)
+{
+  string line;
+  while ((long)line.size() < n)
+    line += "<INTU.BANKID>1234";
+  line += "\n";
+  double start = now();
+  double total = 0;
+  for (int i = 0; i < LINE_CALLS; i++)
+    total += sanitize_proprietary_tags(line).size();
+  sink = total;
+  return now() - start;
+}
+
+static double case_strip(long n)
+{
+  static const char pattern[] = " x\t\r\ny  ";
+  string input;
+  for (long i = 0; i < n; i++)
+    input += pattern[i % (sizeof(pattern) - 1)];
+  string s = input;
+  double start = now();
+  strip_whitespace(s);
+  double elapsed = now() - start;
+  sink = s.size();
+  return elapsed;
+}
+
+/* ---------------- Whole files ---------------- */
+
+static double parse(const OfxGenOptions &options)
+{
+  const char *filename = "complexity.ofx";
+  {
+    ofstream out(filename, ios::binary);
+    ofxgen_generate(options, out);
+    if (!out.good())
+    {
+      fprintf(stderr, "ofxcomplexity: unable to write %s\n", filename);
+      exit(1);
+    }
+  }
+  LibofxContextPtr ctx = libofx_get_new_context();
+  if (dtd_dir != NULL)
+    libofx_set_dtd_dir(ctx, dtd_dir);
+  double start = now();
+  libofx_proc_file(ctx, filename, AUTODETECT);
+  double elapsed = now() - start;
+  libofx_free_context(ctx);
+  remove(filename);
+  return elapsed;
+}
+
+static double case_transactions(long n)
+{
+  OfxGenOptions options;
+  options.transactions = n;
+  return parse(options);
+}
+
+static double case_accounts(long n)
+{
+  OfxGenOptions options;
+  options.accounts = n;
+  options.transactions = 1;
+  return parse(options);
+}
+
+static double case_securities(long n)
+{
+  OfxGenOptions options;
+  options.accounts = 0;
+  options.securities = n;
+  options.transactions = n;
+  return parse(options);
+}
+
+static double case_proprietary(long n)
+{
+  OfxGenOptions options;
+  options.transactions = n;
+  options.proprietary = 1;
+  return parse(options);
+}
+
+/* ---------------- Driver ---------------- */
+
+struct Case
+{
+  const char *name;
+  CaseFunction function;
+  long base; /**< Smallest size, at --scale=1 */
+};
+
+static const Case cases[] =
+{
+  { "sanitize_proprietary_tags/proprietary-line", case_sanitize, 128 },
+  { "strip_whitespace/mixed-whitespace", case_strip, 1000000 },
+  { "parse/transactions-in-one-account", case_transactions, 2000 },
+  { "parse/accounts", case_accounts, 1000 },
+  { "parse/securities", case_securities, 1000 },
+  { "parse/proprietary-tags", case_proprietary, 2000 },
+};
+
+int main(int argc, char *argv[])
+{
+  const char *filter = NULL;
+  double scale = 1;
+  int repeat = 3;
+  double max_exponent = 1.3;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "--scale=", 8) == 0)
+      scale = atof(argv[i] + 8);
+    else if (strncmp(argv[i], "--repeat=", 9) == 0)
+      repeat = atoi(argv[i] + 9);
+    else if (strncmp(argv[i], "--max-exponent=", 15) == 0)
+      max_exponent = atof(argv[i] + 15);
+    else if (strncmp(argv[i], "--dtd-dir=", 10) == 0)
+      dtd_dir = argv[i] + 10;
+    else if (argv[i][0] == '-')
+    {
+      fprintf(stderr, "usage: %s [--scale=F] [--repeat=N] [--max-exponent=K] [--dtd-dir=DIR] [filter]\n", argv[0]);
+      return 1;
+    }
+    else
+      filter = argv[i];
+  }
+  if (scale <= 0 || repeat < 1)
+  {
+    fprintf(stderr, "%s: --scale and --repeat must be positive\n", argv[0]);
+    return 1;
+  }
+
+  static const int multipliers[] = { 1, 2, 4, 8 };
+  static const int steps = sizeof(multipliers) / sizeof(multipliers[0]);
+  int failures = 0;
+  printf("%-44s %10s %10s %10s %10s %9s\n", "case", "1x s", "2x s", "4x s", "8x s", "exponent");
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+  {
+    if (filter != NULL && strstr(cases[c].name, filter) == NULL)
+      continue;
+    long base = (long)(cases[c].base * scale);
+    if (base < 1)
+      base = 1;
+    double times[steps];
+    for (int s = 0; s < steps; s++)
+    {
+      /* The best of several runs is the least disturbed by the rest of the system */
+      times[s] = 0;
+      for (int r = 0; r < repeat; r++)
+      {
+        double t = cases[c].function(base * multipliers[s]);
+        if (r == 0 || t < times[s])
+          times[s] = t;
+      }
+    }
+    double exponent = log(times[steps - 1] / times[0]) / log((double)multipliers[steps - 1]);
+    bool ok = exponent <= max_exponent;
+    printf("%-44s %10.4f %10.4f %10.4f %10.4f %9.2f%s\n", cases[c].name,
+           times[0], times[1], times[2], times[3], exponent, ok ? "" : "  FAIL");
+    fflush(stdout);
+    if (!ok)
+      failures++;
+  }
+  if (failures == 0)
+    printf("PASS\n");
+  else
+    printf("%d case(s) grow faster than n^%.2f\n", failures, max_exponent);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/***************************************************************************
+                          ofxgen.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Code for the ofxgen benchmark utility
+ *
+ * ofxgen writes a synthetic statement file to stdout, for benchmarking.
+ *
+ * usage: ofxgen [options] > file
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "ofx_generator.hh"
+
+using namespace std;
+
+static void usage(const char *program)
+{
+  cerr << "usage: " << program << " [options] > file\n"
+       << "  --format=ofx1|qfx|ofx2|ofc  file format (default ofx1)\n"
+       << "  --encoding=cp1252|latin1|utf8  character set (default cp1252)\n"
+       << "  --accounts=N          bank accounts (default 1)\n"
+       << "  --transactions=N      transactions per account (default 1000)\n"
+       << "  --securities=N        add an investment account trading N securities (default 0)\n"
+       << "  --proprietary=P       fraction of transactions with a proprietary tag, 0 to 1 (default 0)\n"
+       << "  --minified            whole body on one line instead of one tag per line\n"
+       << "  --crlf                DOS line endings\n"
+       << "  --seed=N              random seed (default 1)\n"
+       << "  --output=FILE         write to FILE instead of stdout\n";
+}
+
+/** If arg is --name=value, sets value and returns true */
+static bool option(const char *arg, const char *name, string &value)
+{
+  size_t length = strlen(name);
+  if (strncmp(arg, name, length) != 0 || arg[length] != '=')
+    return false;
+  value = arg + length + 1;
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  OfxGenOptions options;
+  string output;
+  string value;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    bool ok = true;
+    if (option(arg, "--format", value))
+      ok = ofxgen_parse_format(value, options.format);
+    else if (option(arg, "--encoding", value))
+      ok = ofxgen_parse_encoding(value, options.encoding);
+    else if (option(arg, "--accounts", value))
+      options.accounts = atoi(value.c_str());
+    else if (option(arg, "--transactions", value))
+      options.transactions = atoi(value.c_str());
+    else if (option(arg, "--securities", value))
+      options.securities = atoi(value.c_str());
+    else if (option(arg, "--proprietary", value))
+      options.proprietary = atof(value.c_str());
+    else if (option(arg, "--seed", value))
+      options.seed = strtoul(value.c_str(), NULL, 10);
+    else if (option(arg, "--output", value))
+      output = value;
+    else if (strcmp(arg, "--minified") == 0)
+      options.minified = true;
+    else if (strcmp(arg, "--crlf") == 0)
+      options.crlf = true;
+    else
+      ok = false;
+    if (!ok)
+    {
+      cerr << argv[0] << ": invalid option " << arg << "\n";
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (options.format == OfxGenOptions::OFC && options.securities > 0)
+  {
+    cerr << argv[0] << ": OFC files have no securities, ignoring --securities\n";
+    options.securities = 0;
+  }
+
+  if (output.empty())
+  {
+    ofxgen_generate(options, cout);
+    return cout.good() ? 0 : 1;
+  }
+  ofstream out(output.c_str(), ios::binary);
+  if (!out)
+  {
+    cerr << argv[0] << ": unable to open " << output << "\n";
+    return 1;
+  }
+  ofxgen_generate(options, out);
+  return out.good() ? 0 : 1;
+}
@@ -0,0 +1,331 @@
+/***************************************************************************
+                          ofxmemscale.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Memory scaling check: peak RSS and allocations versus file size
+ *
+ * ofxmemscale generates statements of increasing transaction counts,
+ * parses each of them, and records the peak resident set size, the peak
+ * heap in use, the number of heap allocations and the number of
+ * containers allocated by libofx.  It exits with a non zero status if the
+ * cost of an additional transaction grows with the file (superlinear
+ * growth), or if it is above a budget.
+ *
+ * The sizes must be increasing: the peak RSS of the process is a high
+ * water mark, so the peak RSS of each file is only known if it is the
+ * largest one parsed so far.
+ *
+ * usage: ofxmemscale [--sizes=N,N,...] [--rss-budget=BYTES] [--alloc-budget=N]
+ *                    [--max-growth=F] [--dtd-dir=DIR] [--keep]
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include "libofx.h"
+#include "ofx_generator.hh"
+
+using namespace std;
+
+/* ---------------- Heap accounting ----------------
+ * The global allocation functions are replaced for the whole process,
+ * libofx and OpenSP included.  Each block carries its size in a header,
+ * so that the heap in use can be tracked. */
+
+static unsigned long long heap_allocations = 0;
+static unsigned long long heap_in_use = 0;
+static unsigned long long heap_peak = 0;
+
+static const size_t HEADER_SIZE = 16; /* Keeps the blocks aligned for any type */
+
+static void *counted_malloc(size_t size)
+{
+  char *block = (char *)malloc(size + HEADER_SIZE);
+  if (block == NULL)
+    return NULL;
+  *(size_t *)block = size;
+  heap_allocations++;
+  heap_in_use += size;
+  if (heap_in_use > heap_peak)
+    heap_peak = heap_in_use;
+  return block + HEADER_SIZE;
+}
+
+static void counted_free(void *ptr)
+{
+  if (ptr == NULL)
+    return;
+  char *block = (char *)ptr - HEADER_SIZE;
+  heap_in_use -= *(size_t *)block;
+  free(block);
+}
+
+void *operator new(size_t size)
+{
+  void *ptr = counted_malloc(size);
+  if (ptr == NULL)
+    throw bad_alloc();
+  return ptr;
+}
+
+void *operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void *operator new(size_t size, const nothrow_t &) throw()
+{
+  return counted_malloc(size);
+}
+
+void *operator new[](size_t size, const nothrow_t &) throw()
+{
+  return counted_malloc(size);
+}
+
+void operator delete(void *ptr) throw()
+{
+  counted_free(ptr);
+}
+
+void operator delete[](void *ptr) throw()
+{
+  counted_free(ptr);
+}
+
+void operator delete(void *ptr, const nothrow_t &) throw()
+{
+  counted_free(ptr);
+}
+
+void operator delete[](void *ptr, const nothrow_t &) throw()
+{
+  counted_free(ptr);
+}
+
+/* ---------------- Measurements ---------------- */
+
+/** Peak resident set size of the process, in bytes; 0 if unknown */
+static double peak_rss()
+{
+#ifdef _WIN32
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#ifdef __APPLE__
+  return usage.ru_maxrss;
+#else
+  return usage.ru_maxrss * 1024.0;
+#endif
+#endif
+}
+
+static double now()
+{
+  return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Measurement
+{
+  long transactions; /**< Generated transactions */
+  unsigned long reported; /**< Transactions reported to the callback */
+  double seconds;
+  double rss; /**< Peak RSS of the process after the parse */
+  double heap; /**< Peak heap in use during the parse, above what was in use before */
+  double allocations; /**< Heap allocations during the parse */
+  double containers; /**< Containers allocated by libofx */
+};
+
+static int transaction_cb(const struct OfxTransactionData, void *count)
+{
+  (*(unsigned long *)count)++;
+  return 0;
+}
+
+static bool measure(long transactions, const char *dtd_dir, bool keep, Measurement &m)
+{
+  char filename[64];
+  snprintf(filename, sizeof(filename), "memscale-%ld.ofx", transactions);
+  {
+    OfxGenOptions options;
+    options.transactions = transactions;
+    ofstream out(filename, ios::binary);
+    ofxgen_generate(options, out);
+    if (!out.good())
+    {
+      fprintf(stderr, "ofxmemscale: unable to write %s\n", filename);
+      return false;
+    }
+  }
+
+  LibofxContextPtr ctx = libofx_get_new_context();
+  if (dtd_dir != NULL)
+    libofx_set_dtd_dir(ctx, dtd_dir);
+  m.transactions = transactions;
+  m.reported = 0;
+  ofx_set_transaction_cb(ctx, transaction_cb, &m.reported);
+
+  unsigned long long allocations_before = heap_allocations;
+  unsigned long long in_use_before = heap_in_use;
+  heap_peak = heap_in_use;
+  double start = now();
+  libofx_proc_file(ctx, filename, OFX);
+  m.seconds = now() - start;
+  m.rss = peak_rss();
+  m.heap = (double)(heap_peak - in_use_before);
+  m.allocations = (double)(heap_allocations - allocations_before);
+
+  struct LibofxStats stats;
+  libofx_get_stats(ctx, &stats);
+  m.containers = (double)stats.allocations;
+  libofx_free_context(ctx);
+
+  if (!keep)
+    remove(filename);
+  return true;
+}
+
+/** Cost of one more transaction between two measurements */
+static double marginal(const Measurement &a, const Measurement &b, double Measurement::*field)
+{
+  return (b.*field - a.*field) / (b.transactions - a.transactions);
+}
+
+int main(int argc, char *argv[])
+{
+  vector<long> sizes;
+  double rss_budget = 8192;
+  double alloc_budget = 200;
+  double max_growth = 1.5;
+  const char *dtd_dir = NULL;
+  bool keep = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "--sizes=", 8) == 0)
+    {
+      for (const char *p = argv[i] + 8; *p != '\0';)
+      {
+        char *end;
+        sizes.push_back(strtol(p, &end, 10));
+        p = *end == ',' ? end + 1 : end;
+        if (end == p)
+          break;
+      }
+    }
+    else if (strncmp(argv[i], "--rss-budget=", 13) == 0)
+      rss_budget = atof(argv[i] + 13);
+    else if (strncmp(argv[i], "--alloc-budget=", 15) == 0)
+      alloc_budget = atof(argv[i] + 15);
+    else if (strncmp(argv[i], "--max-growth=", 13) == 0)
+      max_growth = atof(argv[i] + 13);
+    else if (strncmp(argv[i], "--dtd-dir=", 10) == 0)
+      dtd_dir = argv[i] + 10;
+    else if (strcmp(argv[i], "--keep") == 0)
+      keep = true;
+    else
+    {
+      fprintf(stderr, "usage: %s [--sizes=N,N,...] [--rss-budget=BYTES] [--alloc-budget=N]\n"
+              "       [--max-growth=F] [--dtd-dir=DIR] [--keep]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (sizes.empty())
+  {
+    sizes.push_back(1000);
+    sizes.push_back(10000);
+    sizes.push_back(100000);
+    sizes.push_back(1000000);
+  }
+  for (size_t i = 0; i < sizes.size(); i++)
+  {
+    if (sizes[i] <= 0 || (i > 0 && sizes[i] <= sizes[i - 1]))
+    {
+      fprintf(stderr, "%s: the sizes must be positive and increasing\n", argv[0]);
+      return 1;
+    }
+  }
+  if (sizes.size() < 3)
+  {
+    fprintf(stderr, "%s: at least three sizes are needed\n", argv[0]);
+    return 1;
+  }
+
+  printf("%12s %9s %11s %10s %11s %12s %10s %12s\n", "transactions", "parse s", "peak RSS MB",
+         "RSS/tx B", "peak heap MB", "allocations", "allocs/tx", "containers");
+  vector<Measurement> results;
+  int failures = 0;
+  for (size_t i = 0; i < sizes.size(); i++)
+  {
+    Measurement m;
+    if (!measure(sizes[i], dtd_dir, keep, m))
+      return 1;
+    results.push_back(m);
+    if (i == 0)
+      printf("%12ld %9.3f %11.1f %10s %11.1f %12.0f %10s %12.0f\n", m.transactions, m.seconds,
+             m.rss / 1e6, "-", m.heap / 1e6, m.allocations, "-", m.containers);
+    else
+      printf("%12ld %9.3f %11.1f %10.0f %11.1f %12.0f %10.1f %12.0f\n", m.transactions, m.seconds,
+             m.rss / 1e6, marginal(results[i - 1], m, &Measurement::rss), m.heap / 1e6,
+             m.allocations, marginal(results[i - 1], m, &Measurement::allocations), m.containers);
+    fflush(stdout);
+    if (m.reported != (unsigned long)m.transactions)
+    {
+      printf("FAIL: %ld transactions generated, %lu reported\n", m.transactions, m.reported);
+      failures++;
+    }
+  }
+
+  /* The first step includes the start up costs (DTD, OpenSP tables), so
+   * the growth is measured from the second step on */
+  size_t last = results.size() - 1;
+  struct
+  {
+    const char *name;
+    double Measurement::*field;
+    double budget;
+  } checks[] =
+  {
+    { "peak RSS", &Measurement::rss, rss_budget },
+    { "peak heap", &Measurement::heap, rss_budget },
+    { "allocations", &Measurement::allocations, alloc_budget },
+  };
+  for (size_t c = 0; c < sizeof(checks) / sizeof(checks[0]); c++)
+  {
+    double reference = marginal(results[0], results[1], checks[c].field);
+    double largest = marginal(results[last - 1], results[last], checks[c].field);
+    if (largest > checks[c].budget)
+    {
+      printf("FAIL: %s per transaction is %.1f, above the budget of %.1f\n",
+             checks[c].name, largest, checks[c].budget);
+      failures++;
+    }
+    if (reference > 0 && largest > reference * max_growth)
+    {
+      printf("FAIL: %s per transaction grows from %.1f to %.1f, more than %.2fx: superlinear\n",
+             checks[c].name, reference, largest, max_growth);
+      failures++;
+    }
+  }
+  if (failures == 0)
+    printf("PASS\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,299 @@
+/***************************************************************************
+                          ofxmicrobench.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Microbenchmarks of the per element conversion functions
+ *
+ * Times ofxdate_to_time_t(), ofxamount_to_double(), strip_whitespace(),
+ * CharStringtostring(), sanitize_proprietary_tags() and find_dtd() on
+ * realistic and adversarial inputs, and prints the time per call.  Each
+ * benchmark runs for at least --min-time seconds (default 0.2).
+ *
+ * usage: ofxmicrobench [--min-time=SECONDS] [--dtd-dir=DIR] [filter]
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ParserEventGeneratorKit.h"
+#include "libofx.h"
+#include "ofx_utilities.hh"
+#include "ofx_preproc.hh"
+#include "context.hh"
+
+using namespace std;
+
+/** Keeps results alive, so that the compiler can't drop the calls */
+static volatile double sink;
+
+static double min_time = 0.2;
+static string dtd_dir;
+
+typedef void (*BenchmarkFunction)(long iterations, const void *arg);
+
+static double now()
+{
+  return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** Run fn with growing iteration counts until it takes min_time, print ns per call */
+static void run(const char *filter, const string &name, BenchmarkFunction fn, const void *arg)
+{
+  if (filter != NULL && name.find(filter) == string::npos)
+    return;
+  long iterations = 1;
+  double elapsed = 0;
+  for (;;)
+  {
+    double start = now();
+    fn(iterations, arg);
+    elapsed = now() - start;
+    if (elapsed >= min_time || iterations >= (1L << 40))
+      break;
+    /* Aim a bit past min_time, without growing more than 10x at once */
+    double factor = elapsed > 0 ? min_time * 1.2 / elapsed : 10;
+    iterations = (long)(iterations * (factor > 10 ? 10 : factor < 2 ? 2 : factor));
+  }
+  printf("%-56s %12.1f ns %12ld calls\n", name.c_str(), elapsed * 1e9 / iterations, iterations);
+}
+
+/* ---------------- ofxdate_to_time_t ---------------- */
+
+struct DateCase
+{
+  vector<string> dates; /**< Cycled through, more than the memo holds to defeat it */
+};
+
+static void bench_date(long iterations, const void *arg)
+{
+  const vector<string> &dates = ((const DateCase *)arg)->dates;
+  OfxTimezoneCache cache;
+  double total = 0;
+  size_t n = dates.size();
+  for (long i = 0; i < iterations; i++)
+    total += ofxdate_to_time_t(dates[i % n], &cache);
+  sink = total;
+}
+
+static DateCase date_case(const char *format, int count)
+{
+  DateCase c;
+  char buffer[128];
+  for (int i = 0; i < count; i++)
+  {
+    snprintf(buffer, sizeof(buffer), format, 2000 + i % 30, 1 + i % 12, 1 + i % 28, i % 24, i % 60);
+    c.dates.push_back(buffer);
+  }
+  return c;
+}
+
+/* ---------------- ofxamount_to_double ---------------- */
+
+static void bench_amount(long iterations, const void *arg)
+{
+  const string &amount = *(const string *)arg;
+  double total = 0;
+  long long micros;
+  for (long i = 0; i < iterations; i++)
+  {
+    total += ofxamount_to_double(amount, &micros);
+    total += micros;
+  }
+  sink = total;
+}
+
+/* ---------------- strip_whitespace ---------------- */
+
+static void bench_strip(long iterations, const void *arg)
+{
+  const string &input = *(const string *)arg;
+  string s;
+  double total = 0;
+  for (long i = 0; i < iterations; i++)
+  {
+    s = input;
+    strip_whitespace(s);
+    total += s.size();
+  }
+  sink = total;
+}
+
+/* ---------------- CharStringtostring ---------------- */
+
+static void bench_charstring(long iterations, const void *arg)
+{
+  const vector<SGMLApplication::Char> &chars = *(const vector<SGMLApplication::Char> *)arg;
+  SGMLApplication::CharString source;
+  source.ptr = chars.empty() ? NULL : &chars[0];
+  source.len = chars.size();
+  string dest;
+  double total = 0;
+  for (long i = 0; i < iterations; i++)
+  {
+    CharStringtostring(source, dest);
+    total += dest.size();
+  }
+  sink = total;
+}
+
+static vector<SGMLApplication::Char> chars(const string &s, SGMLApplication::Char wide)
+{
+  vector<SGMLApplication::Char> result;
+  for (size_t i = 0; i < s.size(); i++)
+    result.push_back(wide != 0 && i % 8 == 7 ? wide : (unsigned char)s[i]);
+  return result;
+}
+
+/* ---------------- sanitize_proprietary_tags ---------------- */
+
+static void bench_sanitize(long iterations, const void *arg)
+{
+  const string &line = *(const string *)arg;
+  double total = 0;
+  for (long i = 0; i < iterations; i++)
+    total += sanitize_proprietary_tags(line).size();
+  sink = total;
+}
+
+/** A line of about length bytes where the given fraction of the elements are proprietary */
+static string tagged_line(size_t length, double proprietary)
+{
+  string line;
+  double owed = 0;
+  while (line.size() < length)
+  {
+    owed += proprietary;
+    if (owed >= 1)
+    {
+      line += "<INTU.XFER>12345";
+      owed -= 1;
+    }
+    else
+    {
+      line += "<TRNAMT>-12.34";
+    }
+  }
+  return line + "\n";
+}
+
+/* ---------------- find_dtd ---------------- */
+
+static void bench_find_dtd(long iterations, const void *arg)
+{
+  LibofxContextPtr ctx = libofx_get_new_context();
+  const char *dir = (const char *)arg;
+  if (dir != NULL)
+    libofx_set_dtd_dir(ctx, dir);
+  double total = 0;
+  for (long i = 0; i < iterations; i++)
+    total += find_dtd(ctx, OFX160DTD_FILENAME).size();
+  libofx_free_context(ctx);
+  sink = total;
+}
+
+int main(int argc, char *argv[])
+{
+  const char *filter = NULL;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "--min-time=", 11) == 0)
+      min_time = atof(argv[i] + 11);
+    else if (strncmp(argv[i], "--dtd-dir=", 10) == 0)
+      dtd_dir = argv[i] + 10;
+    else if (argv[i][0] == '-')
+    {
+      fprintf(stderr, "usage: %s [--min-time=SECONDS] [--dtd-dir=DIR] [filter]\n", argv[0]);
+      return 1;
+    }
+    else
+      filter = argv[i];
+  }
+
+  /* Dates: the memo hit case repeats one string, the miss case cycles through more than it holds */
+  DateCase date_hit = date_case("%04d%02d%02d", 1);
+  DateCase date_day = date_case("%04d%02d%02d", 1000);
+  DateCase date_time = date_case("%04d%02d%02d%02d%02d00", 1000);
+  DateCase date_tz = date_case("%04d%02d%02d%02d%02d00.000[-5:EST]", 1000);
+  DateCase date_tz_hit = date_case("%04d%02d%02d%02d%02d00.000[-5:EST]", 1);
+  DateCase date_frac_tz = date_case("%04d%02d%02d%02d%02d00.000[+5.75:NPT]", 1000);
+  DateCase date_short = date_case("%04d%02d", 1000);
+  DateCase date_long;
+  for (int i = 0; i < 1000; i++)
+    date_long.dates.push_back(date_tz.dates[i] + string(200, '9'));
+  run(filter, "ofxdate_to_time_t/date/memo-hit", bench_date, &date_hit);
+  run(filter, "ofxdate_to_time_t/date", bench_date, &date_day);
+  run(filter, "ofxdate_to_time_t/datetime", bench_date, &date_time);
+  run(filter, "ofxdate_to_time_t/datetime-tz/memo-hit", bench_date, &date_tz_hit);
+  run(filter, "ofxdate_to_time_t/datetime-tz", bench_date, &date_tz);
+  run(filter, "ofxdate_to_time_t/datetime-fractional-tz", bench_date, &date_frac_tz);
+  run(filter, "ofxdate_to_time_t/adversarial-too-short", bench_date, &date_short);
+  run(filter, "ofxdate_to_time_t/adversarial-200-digit-tail", bench_date, &date_long);
+
+  const string amounts[][2] =
+  {
+    { "ofxamount_to_double/simple", "-123.45" },
+    { "ofxamount_to_double/integer", "5000" },
+    { "ofxamount_to_double/comma-decimal", "1234,56" },
+    { "ofxamount_to_double/padded", "  +0000012345.6700  " },
+    { "ofxamount_to_double/exponent", "1.5E+3" },
+    { "ofxamount_to_double/adversarial-40-digits", "1234567890123456789012345678901234567890.5" },
+    { "ofxamount_to_double/adversarial-1000-digits", string(1000, '7') + ".25" },
+    { "ofxamount_to_double/adversarial-garbage", "N/A" },
+  };
+  for (size_t i = 0; i < sizeof(amounts) / sizeof(amounts[0]); i++)
+    run(filter, amounts[i][0], bench_amount, &amounts[i][1]);
+
+  const string strips[][2] =
+  {
+    { "strip_whitespace/clean", "Grocery store" },
+    { "strip_whitespace/trailing-crlf", "Grocery store\r\n" },
+    { "strip_whitespace/both-ends", "   Grocery store   \r\n" },
+    { "strip_whitespace/adversarial-10k-spaces", string(5000, ' ') + "x" + string(5000, ' ') },
+    { "strip_whitespace/adversarial-10k-value", string(10000, 'x') },
+  };
+  for (size_t i = 0; i < sizeof(strips) / sizeof(strips[0]); i++)
+    run(filter, strips[i][0], bench_strip, &strips[i][1]);
+
+  vector<SGMLApplication::Char> cs_8 = chars("CHECKING", 0);
+  vector<SGMLApplication::Char> cs_64 = chars(string(64, 'a'), 0);
+  vector<SGMLApplication::Char> cs_4k = chars(string(4096, 'a'), 0);
+  vector<SGMLApplication::Char> cs_wide = chars(string(64, 'a'), 0x20AC);
+  vector<SGMLApplication::Char> cs_wide_4k = chars(string(4096, 'a'), 0x20AC);
+  run(filter, "CharStringtostring/8", bench_charstring, &cs_8);
+  run(filter, "CharStringtostring/64", bench_charstring, &cs_64);
+  run(filter, "CharStringtostring/4096", bench_charstring, &cs_4k);
+  run(filter, "CharStringtostring/64-with-references", bench_charstring, &cs_wide);
+  run(filter, "CharStringtostring/4096-with-references", bench_charstring, &cs_wide_4k);
+
+  static const size_t lengths[] = { 16, 256, 1024, 4096 };
+  static const double densities[] = { 0, 0.1, 1 };
+  for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+  {
+    for (size_t d = 0; d < sizeof(densities) / sizeof(densities[0]); d++)
+    {
+      char name[128];
+      snprintf(name, sizeof(name), "sanitize_proprietary_tags/%lu-bytes/%.0f%%-proprietary",
+               (unsigned long)lengths[l], densities[d] * 100);
+      string line = tagged_line(lengths[l], densities[d]);
+      run(filter, name, bench_sanitize, &line);
+    }
+  }
+  string comment_line = "<MEMO>" + string(1000, '<') + "\n";
+  run(filter, "sanitize_proprietary_tags/adversarial-unclosed-tags", bench_sanitize, &comment_line);
+
+  if (!dtd_dir.empty())
+    run(filter, "find_dtd/context-dir", bench_find_dtd, dtd_dir.c_str());
+  run(filter, "find_dtd/default-search", bench_find_dtd, NULL);
+  return 0;
+}
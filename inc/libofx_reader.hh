@@ -0,0 +1,134 @@
+/***************************************************************************
+                          libofx_reader.hh
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief C++ interface reading the events of a file one by one
+ *
+ * ofx::Reader gives the same events as the callbacks of libofx.h, but the
+ * application asks for them when it is ready, instead of having them
+ * pushed to callbacks:
+ *
+ * \code
+ * ofx::Reader reader(ctx, "statement.ofx");
+ * for (ofx::Event event = reader.next(); event.type != ofx::Event::END; event = reader.next())
+ * {
+ *   if (event.type == ofx::Event::TRANSACTION)
+ *     store(*event.transaction);
+ * }
+ * \endcode
+ *
+ * The file is parsed on a thread of its own, which queues at most 1024
+ * events, about 1.6 MB, ahead of the application.  The parse only stays
+ * that close for files holding bank and credit card statements alone:
+ * from the first security or investment statement on, the rest of the
+ * file is kept in memory until it is all parsed, as by
+ * libofx_proc_file().  The log callback of the context is called from
+ * that thread.
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef LIBOFX_READER_HH
+#define LIBOFX_READER_HH
+
+#include "libofx.h"
+
+#if defined(HAVE_GCC_VISIBILITY_EXTS) && defined(IN_LIBOFX)
+#  pragma GCC visibility push(default)
+#endif
+
+namespace ofx
+{
+
+/**
+ * \brief An event of a file, returned by Reader::next()
+ *
+ The member matching the type points to the same data as the callback
+ of that event would get.  The data belongs to the Reader, and stays
+ valid until the next call of Reader::next().
+ */
+struct Event
+{
+  enum Type
+  {
+    END, /**< No more events: the end of the file, or Reader::abort() */
+    STATUS, /**< See ofx_set_status_cb() */
+    SECURITY, /**< See ofx_set_security_cb() */
+    ACCOUNT, /**< See ofx_set_account_cb() */
+    STATEMENT, /**< See ofx_set_statement_cb() */
+    TRANSACTION /**< See ofx_set_transaction_cb() */
+  };
+  Type type;
+  union
+  {
+    const struct OfxStatusData *status;
+    const struct OfxSecurityData *security;
+    const struct OfxAccountData *account;
+    const struct OfxStatementData *statement;
+    const struct OfxTransactionData *transaction;
+  };
+
+  Event()
+    : type(END)
+    , status(0)
+  {
+  };
+};
+
+/**
+ * \brief Reads the events of an OFX or OFC file one by one
+ *
+ The events come in the same order as the callbacks of
+ libofx_proc_file() with libofx_set_pipelined_callbacks(): the events of
+ each bank or credit card statement are available as soon as it is
+ parsed, and the status events come between the statements.  From the
+ first security or investment statement on, the events only come once
+ the whole file is parsed.
+ */
+class Reader
+{
+public:
+  /**
+   * \brief Starts reading a file
+   *
+   @param libofx_context gives the DTD directory and the log callback; its
+   ofx_set_*_cb() callbacks are not called.  The statistics of the file
+   are added to it when the Reader is destroyed.  NULL for the defaults.
+   @param file_type as for libofx_proc_file()
+  */
+  Reader(LibofxContextPtr libofx_context, const char *p_filename, enum LibofxFileFormat file_type = AUTODETECT);
+  /** Stops the parse if the end of the file wasn't reached */
+  ~Reader();
+
+  /** The next event, waiting until it is parsed.  The previous one is no
+      longer valid. */
+  Event next();
+  /** Don't return the remaining events of the current statement, as a
+      callback returning LIBOFX_SKIP_STATEMENT */
+  void skip_statement();
+  /** Stop the parse, as a callback returning LIBOFX_ABORT: next() returns
+      END from now on */
+  void abort();
+
+private:
+  Reader(const Reader &) = delete;
+  Reader &operator=(const Reader &) = delete;
+
+  struct Impl;
+  Impl *impl;
+};
+
+}
+
+#if defined(HAVE_GCC_VISIBILITY_EXTS) && defined(IN_LIBOFX)
+#  pragma GCC visibility pop
+#endif
+
+#endif // end of LIBOFX_READER_HH
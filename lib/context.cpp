@@ -12,6 +12,7 @@
  ***************************************************************************/
 #include <config.h>
 #include "context.hh"
+#include "probes.hh"
 
 using namespace std;
 
@@ -29,8 +30,16 @@ LibofxContext::LibofxContext()
   , _transactionData(0)
   , _securityData(0)
   , _statusData(0)
+  , _logCallback(0)
+  , _logData(0)
+  , _logMask(0)
+  , _stop(CONTINUE)
+  , _workerThreads(1)
+  , _keptMainContainers(0)
+  , _pipelined(false)
+  , _streamAccounts(false)
 {
-
+  memset(&_stats, 0, sizeof(_stats));
 }
 
 
@@ -41,6 +50,30 @@ LibofxContext::~LibofxContext()
 
 
 
+void LibofxContext::reset()
+{
+  drainLog();
+  _current_file_type = OFX;
+  memset(&_stats, 0, sizeof(_stats));
+  _stop = CONTINUE;
+}
+
+
+
+void LibofxContext::checkStop(int retval)
+{
+  if (retval == LIBOFX_ABORT)
+  {
+    _stop = ABORT;
+  }
+  else if (retval == LIBOFX_SKIP_STATEMENT && _stop == CONTINUE)
+  {
+    _stop = SKIP_STATEMENT;
+  }
+}
+
+
+
 LibofxFileFormat LibofxContext::currentFileType() const
 {
   return _current_file_type;
@@ -55,47 +88,114 @@ void LibofxContext::setCurrentFileType(LibofxFileFormat t)
 
 
 
+void LibofxContext::logMessage(OfxMsgType type, const string &text,
+                               int line, int column)
+{
+  if (!_logQueue.push(type, text, line, column))
+  {
+    drainLog();
+    if (!_logQueue.push(type, text, line, column))
+      _logQueue.dropped();
+  }
+}
+
+
+
+int LibofxContext::drainLog()
+{
+  return _logQueue.drain(_logCallback, _logData);
+}
+
+
+
+void LibofxContext::setLogCallback(int level_mask, LibofxLogCallback cb,
+                                   void *user_data)
+{
+  _logMask = level_mask;
+  _logCallback = cb;
+  _logData = user_data;
+}
+
+
+
 int LibofxContext::statementCallback(const struct OfxStatementData data)
 {
-  if (_statementCallback)
-    return _statementCallback(data, _statementData);
-  return 0;
+  int retval = 0;
+  if (_statementCallback && !aborted())
+  {
+    OfxStatsTimer timer(_stats.callback_ns);
+    OFX_PROBE1(callback__start, "statement");
+    retval = _statementCallback(data, _statementData);
+    OFX_PROBE2(callback__end, "statement", retval);
+    checkStop(retval);
+  }
+  return retval;
 }
 
 
 
 int LibofxContext::accountCallback(const struct OfxAccountData data)
 {
-  if (_accountCallback)
-    return _accountCallback(data, _accountData);
-  return 0;
+  int retval = 0;
+  if (_accountCallback && !aborted())
+  {
+    OfxStatsTimer timer(_stats.callback_ns);
+    OFX_PROBE1(callback__start, "account");
+    retval = _accountCallback(data, _accountData);
+    OFX_PROBE2(callback__end, "account", retval);
+    checkStop(retval);
+  }
+  return retval;
 }
 
 
 
 int LibofxContext::transactionCallback(const struct OfxTransactionData data)
 {
-  if (_transactionCallback)
-    return _transactionCallback(data, _transactionData);
-  return 0;
+  _stats.transactions++;
+  int retval = 0;
+  if (_transactionCallback && !aborted())
+  {
+    OfxStatsTimer timer(_stats.callback_ns);
+    OFX_PROBE1(callback__start, "transaction");
+    retval = _transactionCallback(data, _transactionData);
+    OFX_PROBE2(callback__end, "transaction", retval);
+    checkStop(retval);
+  }
+  return retval;
 }
 
 
 
 int LibofxContext::securityCallback(const struct OfxSecurityData data)
 {
-  if (_securityCallback)
-    return _securityCallback(data, _securityData);
-  return 0;
+  _stats.securities++;
+  int retval = 0;
+  if (_securityCallback && !aborted())
+  {
+    OfxStatsTimer timer(_stats.callback_ns);
+    OFX_PROBE1(callback__start, "security");
+    retval = _securityCallback(data, _securityData);
+    OFX_PROBE2(callback__end, "security", retval);
+    checkStop(retval);
+  }
+  return retval;
 }
 
 
 
 int LibofxContext::statusCallback(const struct OfxStatusData data)
 {
-  if (_statusCallback)
-    return _statusCallback(data, _statusData);
-  return 0;
+  int retval = 0;
+  if (_statusCallback && !aborted())
+  {
+    OfxStatsTimer timer(_stats.callback_ns);
+    OFX_PROBE1(callback__start, "status");
+    retval = _statusCallback(data, _statusData);
+    OFX_PROBE2(callback__end, "status", retval);
+    checkStop(retval);
+  }
+  return retval;
 }
 
 
@@ -161,6 +261,12 @@ int libofx_free_context( LibofxContextPtr libofx_context_param)
   return 0;
 }
 
+int libofx_reset_context( LibofxContextPtr libofx_context_param)
+{
+  ((LibofxContext *)libofx_context_param)->reset();
+  return 0;
+}
+
 
 
 void libofx_set_dtd_dir(LibofxContextPtr libofx_context,
@@ -170,6 +276,20 @@ void libofx_set_dtd_dir(LibofxContextPtr libofx_context,
 }
 
 
+void libofx_set_worker_threads(LibofxContextPtr libofx_context,
+                               int threads)
+{
+  ((LibofxContext*)libofx_context)->setWorkerThreads(threads > 1 ? threads : 1);
+}
+
+
+void libofx_set_pipelined_callbacks(LibofxContextPtr libofx_context,
+                                    int pipelined)
+{
+  ((LibofxContext*)libofx_context)->setPipelined(pipelined != 0);
+}
+
+
 
 
 
@@ -219,6 +339,41 @@ extern "C" {
 
 
 
+  void libofx_set_log_callback(LibofxContextPtr ctx,
+                               int level_mask,
+                               LibofxLogCallback cb,
+                               void *user_data)
+  {
+    ((LibofxContext*)ctx)->setLogCallback(level_mask, cb, user_data);
+  }
+
+
+
+  int libofx_drain_log(LibofxContextPtr ctx)
+  {
+    return ((LibofxContext*)ctx)->drainLog();
+  }
+
+
+
+  /** total - part, or 0 if the part was timed outside of the total */
+  static unsigned long long exclusive_ns(unsigned long long total, unsigned long long part)
+  {
+    return total > part ? total - part : 0;
+  }
+
+  int libofx_get_stats(LibofxContextPtr ctx, struct LibofxStats *stats)
+  {
+    *stats = ((LibofxContext*)ctx)->stats();
+    /* Make the nested phases exclusive */
+    stats->header_parsing_ns = exclusive_ns(stats->header_parsing_ns, stats->iconv_ns + stats->sanitize_ns);
+    stats->sgml_parsing_ns = exclusive_ns(stats->sgml_parsing_ns, stats->container_ns);
+    stats->container_ns = exclusive_ns(stats->container_ns, stats->callback_ns);
+    return 0;
+  }
+
+
+
 
 }
 
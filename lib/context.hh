@@ -17,11 +17,17 @@
 #include <time.h>		// for time_t
 #include "libofx.h"
 #include "ParserEventGeneratorKit.h"
+#include "ofx_utilities.hh"
+#include "message_queue.hh"
+#include "stats.hh"
 
 #include <string>
+#include <vector>
 
 
 using namespace std;
+class OfxMainContainer;
+
 class LibofxContext
 {
 private:
@@ -41,10 +47,31 @@ private:
 
   std::string _dtdDir;
 
+  OfxTimezoneCache _timezoneCache;
+
+  LibofxLogCallback _logCallback;
+  void * _logData;
+  int _logMask;
+  OfxMessageQueue _logQueue;
+
+  struct LibofxStats _stats;
+
+  /** Set by the callbacks returning LIBOFX_SKIP_STATEMENT or LIBOFX_ABORT */
+  enum { CONTINUE, SKIP_STATEMENT, ABORT } _stop;
+  void checkStop(int retval);
+
+  int _workerThreads;
+  vector<OfxMainContainer *> *_keptMainContainers;
+  bool _pipelined;
+  bool _streamAccounts;
+
 public:
   LibofxContext();
   ~LibofxContext();
 
+  /** Forget the files processed so far, keeping the callbacks, the settings and the caches */
+  void reset();
+
   LibofxFileFormat currentFileType() const;
   void setCurrentFileType(LibofxFileFormat t);
 
@@ -57,6 +84,108 @@ public:
     _dtdDir = s;
   };
 
+  /** Time zone data used for all the dates converted in this context */
+  OfxTimezoneCache *timezoneCache()
+  {
+    return &_timezoneCache;
+  };
+
+  /** Statistics of the files processed in this context.
+
+      While accumulating, sgml_parsing_ns includes container_ns, which
+      includes callback_ns, and header_parsing_ns includes iconv_ns and
+      sanitize_ns; libofx_get_stats() subtracts them. */
+  struct LibofxStats &stats()
+  {
+    return _stats;
+  };
+
+  /** A callback returned LIBOFX_ABORT: no more callbacks, and the parsing should stop */
+  bool aborted() const
+  {
+    return _stop == ABORT;
+  };
+  /** A callback returned LIBOFX_SKIP_STATEMENT or LIBOFX_ABORT: the events of the current statement should stop */
+  bool skipping() const
+  {
+    return _stop != CONTINUE;
+  };
+  /** The next statement begins: ends a LIBOFX_SKIP_STATEMENT */
+  void resume()
+  {
+    if (_stop == SKIP_STATEMENT)
+      _stop = CONTINUE;
+  };
+  /** A new file begins: ends a LIBOFX_ABORT too */
+  void startFile()
+  {
+    _stop = CONTINUE;
+  };
+
+  /** Threads parsing the statements of a file, see libofx_set_worker_threads() */
+  int workerThreads() const
+  {
+    return _workerThreads;
+  };
+  void setWorkerThreads(int threads)
+  {
+    _workerThreads = threads;
+  };
+
+  /** Where the main containers go at the end of the <OFX> element,
+      instead of generating their events; NULL to generate them.  Set on
+      the contexts of the workers of ofx_proc_file_parallel(). */
+  vector<OfxMainContainer *> *keptMainContainers() const
+  {
+    return _keptMainContainers;
+  };
+  void keepMainContainers(vector<OfxMainContainer *> *containers)
+  {
+    _keptMainContainers = containers;
+  };
+
+  /** Callbacks called while another thread parses, see libofx_set_pipelined_callbacks() */
+  bool pipelined() const
+  {
+    return _pipelined;
+  };
+  void setPipelined(bool pipelined)
+  {
+    _pipelined = pipelined;
+  };
+
+  /** Whether the main container generates the events of an account as
+      soon as its statement ends, instead of at the end of the <OFX>
+      element.  Only set on the context of the parsing thread of an
+      OfxPipeline.  The main container stops at the first security or
+      investment account, whose events must wait for the securities. */
+  bool streamAccounts() const
+  {
+    return _streamAccounts;
+  };
+  void setStreamAccounts(bool stream)
+  {
+    _streamAccounts = stream;
+  };
+
+  /** LIBOFX_LOG_* levels wanted by the log callback with OFX_LOG_ROUTED,
+      or 0 if messages should be printed */
+  int logMask() const
+  {
+    return _logCallback ? (_logMask | OFX_LOG_ROUTED) : 0;
+  };
+  /** Queue a message for the log callback; drains the queue if it is full */
+  void logMessage(OfxMsgType type, const string &text, int line, int column);
+  /** Deliver the queued messages to the log callback */
+  int drainLog();
+  void setLogCallback(int level_mask, LibofxLogCallback cb, void *user_data);
+  /** Use the log callback of another context, which must then be safe
+      to call from several threads at once */
+  void shareLogCallback(const LibofxContext &other)
+  {
+    setLogCallback(other._logMask, other._logCallback, other._logData);
+  };
+
   int statementCallback(const struct OfxStatementData data);
   int accountCallback(const struct OfxAccountData data);
   int transactionCallback(const struct OfxTransactionData data);
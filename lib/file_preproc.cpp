@@ -27,6 +27,9 @@
 #include "ofx_preproc.hh"
 #include "context.hh"
 #include "file_preproc.hh"
+#include "ofx_parallel.hh"
+#include "ofx_pipeline.hh"
+#include "probes.hh"
 
 using namespace std;
 const unsigned int READ_BUFFER_SIZE = 1024;
@@ -64,21 +67,33 @@ enum LibofxFileFormat libofx_get_file_format_from_str(const struct LibofxFileFor
   return retval;
 }
 
+/** Detect the format of the file into the context */
+static void detect_file_type(LibofxContext *libofx_context, const char *p_filename)
+{
+  OfxStatsTimer timer(libofx_context->stats().file_detection_ns);
+  OFX_PROBE1(phase__start, "detect");
+  libofx_context->setCurrentFileType(libofx_detect_file_type(p_filename));
+  OFX_PROBE1(phase__end, "detect");
+}
+
 int libofx_proc_file(LibofxContextPtr p_libofx_context, const char * p_filename, LibofxFileFormat p_file_type)
 {
   LibofxContext * libofx_context = (LibofxContext *) p_libofx_context;
+  OfxLogScope log_scope(libofx_context);
+  OFX_PROBE2(parse__start, p_filename, (int)p_file_type);
+  libofx_context->startFile();
 
   if (p_file_type == AUTODETECT)
   {
     message_out(INFO, string("libofx_proc_file(): File format not specified, autodetecting..."));
-    libofx_context->setCurrentFileType(libofx_detect_file_type(p_filename));
+    detect_file_type(libofx_context, p_filename);
     message_out(INFO, string("libofx_proc_file(): Detected file format: ") +
                 libofx_get_file_format_description(LibofxImportFormatList,
                     libofx_context->currentFileType() ));
   }
   else
   {
-    libofx_context->setCurrentFileType(libofx_detect_file_type(p_filename));
+    detect_file_type(libofx_context, p_filename);
     message_out(INFO,
                 string("libofx_proc_file(): File format forced to: ") +
                 libofx_get_file_format_description(LibofxImportFormatList,
@@ -88,7 +103,12 @@ int libofx_proc_file(LibofxContextPtr p_libofx_context, const char * p_filename,
   switch (libofx_context->currentFileType())
   {
   case OFX:
-    ofx_proc_file(libofx_context, p_filename);
+    if (libofx_context->workerThreads() > 1 && ofx_proc_file_parallel(libofx_context, p_filename))
+      break;
+    if (libofx_context->pipelined())
+      ofx_proc_file_pipelined(libofx_context, p_filename);
+    else
+      ofx_proc_file(libofx_context, p_filename);
     break;
   case OFC:
     ofx_proc_file(libofx_context, p_filename);
@@ -96,7 +116,8 @@ int libofx_proc_file(LibofxContextPtr p_libofx_context, const char * p_filename,
   default:
     message_out(ERROR, string("libofx_proc_file(): Detected file format not yet supported ou couldn't detect file format; aborting."));
   }
-  return 0;
+  OFX_PROBE1(parse__end, p_filename);
+  return libofx_context->aborted() ? LIBOFX_ABORT : 0;
 }
 
 enum LibofxFileFormat libofx_detect_file_type(const char * p_filename)
@@ -0,0 +1,91 @@
+/***************************************************************************
+                          message_queue.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Queue of the log messages of a context
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <config.h>
+#include <sstream>
+#include "message_queue.hh"
+
+OfxMessageQueue::OfxMessageQueue()
+  : _head(0)
+  , _tail(0)
+  , _draining(false)
+  , _dropped(0)
+{
+}
+
+
+
+bool OfxMessageQueue::push(OfxMsgType type, const string &text, int line, int column)
+{
+  unsigned long tail = _tail.load(memory_order_relaxed);
+  if (tail - _head.load(memory_order_acquire) >= CAPACITY)
+    return false;
+
+  Slot &slot = _slots[tail % CAPACITY];
+  slot.level = 1 << type;
+  slot.text.assign(text);
+  slot.line = line;
+  slot.column = column;
+
+  /* Publishes the slot to the consumer */
+  _tail.store(tail + 1, memory_order_release);
+  return true;
+}
+
+
+
+int OfxMessageQueue::drain(LibofxLogCallback cb, void *user_data)
+{
+  if (cb == NULL || _draining.exchange(true, memory_order_acquire))
+    return 0;
+
+  int delivered = 0;
+  unsigned long head = _head.load(memory_order_relaxed);
+  unsigned long tail = _tail.load(memory_order_acquire);
+  while (head != tail)
+  {
+    const Slot &slot = _slots[head % CAPACITY];
+    struct OfxLogMessage message;
+    message.level = slot.level;
+    message.text = slot.text.c_str();
+    message.line = slot.line;
+    message.column = slot.column;
+    cb(&message, user_data);
+    delivered++;
+
+    /* Hands the slot back to the producer */
+    _head.store(++head, memory_order_release);
+    if (head == tail)
+      tail = _tail.load(memory_order_acquire);
+  }
+
+  unsigned long dropped = _dropped.exchange(0, memory_order_relaxed);
+  if (dropped > 0)
+  {
+    ostringstream text;
+    text << "LibOFX: " << dropped << " log messages were dropped because the log queue was full";
+    string s = text.str();
+    struct OfxLogMessage message;
+    message.level = LIBOFX_LOG_WARNING;
+    message.text = s.c_str();
+    message.line = -1;
+    message.column = -1;
+    cb(&message, user_data);
+    delivered++;
+  }
+
+  _draining.store(false, memory_order_release);
+  return delivered;
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+                          message_queue.hh
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Queue of the log messages of a context
+ *
+ The messages logged while parsing are queued here by the parsing thread,
+ and handed to the application's log callback by whichever thread drains
+ the queue.
+*/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef MESSAGE_QUEUE_H
+#define MESSAGE_QUEUE_H
+
+#include <atomic>
+#include <string>
+#include "libofx.h"
+#include "messages.hh"
+
+using namespace std;
+
+/**
+ * \brief Fixed size, lock free, single producer single consumer ring of
+ * log messages.
+ *
+ * The slots keep their strings between uses, so once the queue has warmed
+ * up, queueing a message usually costs a copy into already allocated
+ * memory.  Only one thread may push at a time; any number of threads may
+ * call drain(), the ones finding the queue already being drained return
+ * immediately.
+ */
+class OfxMessageQueue
+{
+public:
+  OfxMessageQueue();
+
+  /**
+   * Queue a message.
+   *
+   @return false if the queue is full; the message is not queued.
+  */
+  bool push(OfxMsgType type, const string &text, int line, int column);
+
+  /** Count a message that could not be queued, to be reported by the next drain() */
+  void dropped()
+  {
+    _dropped.fetch_add(1, memory_order_relaxed);
+  };
+
+  /**
+   * Hand every queued message to cb, oldest first.
+   *
+   @return the number of messages delivered, 0 if another thread is
+   already draining.
+  */
+  int drain(LibofxLogCallback cb, void *user_data);
+
+private:
+  enum { CAPACITY = 256 };
+
+  struct Slot
+  {
+    int level;
+    string text;
+    int line;
+    int column;
+  };
+
+  Slot _slots[CAPACITY];
+  atomic<unsigned long> _head; /**< Next slot to read, only moved by the consumer */
+  atomic<unsigned long> _tail; /**< Next slot to write, only moved by the producer */
+  atomic<bool> _draining; /**< Set while a thread is the consumer */
+  atomic<unsigned long> _dropped;
+};
+
+#endif
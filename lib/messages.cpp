@@ -23,9 +23,10 @@
 #include "messages.hh"
 #include "config.h"
 #include "libofx.h"
+#include "context.hh"
 
-SGMLApplication::OpenEntityPtr entity_ptr; /**< Global for determining the line number in OpenSP */
-SGMLApplication::Position position; /**< Global for determining the line number in OpenSP */
+thread_local SGMLApplication::OpenEntityPtr entity_ptr; /**< Global for determining the line number in OpenSP */
+thread_local SGMLApplication::Position position; /**< Global for determining the line number in OpenSP */
 
 int ofx_PARSER_msg = false; /**< If set to true, parser events will be printed to the console */
 int ofx_DEBUG_msg = false;/**< If set to true, general debug messages will be printed to the console */
@@ -40,26 +41,60 @@ int ofx_WARNING_msg = false;/**< If set to true, warning messages will be printe
 int ofx_ERROR_msg = false;/**< If set to true, error messages will be printed to the console */
 int ofx_show_position = true;/**< If set to true, the line number will be shown after any error */
 
+thread_local int ofx_log_mask = 0;
+static thread_local LibofxContext *log_context = NULL; /**< Context whose log callback gets the messages of this thread */
+
+OfxLogScope::OfxLogScope(LibofxContext *context)
+  : _previous_context(log_context)
+  , _previous_mask(ofx_log_mask)
+{
+  log_context = context;
+  ofx_log_mask = context->logMask();
+}
+
+OfxLogScope::~OfxLogScope()
+{
+  if (log_context != _previous_context)
+    log_context->drainLog();
+  log_context = _previous_context;
+  ofx_log_mask = _previous_mask;
+}
+
 void show_line_number()
 {
-  extern SGMLApplication::OpenEntityPtr entity_ptr;
-  extern SGMLApplication::Position position;
+  extern thread_local SGMLApplication::OpenEntityPtr entity_ptr;
+  extern thread_local SGMLApplication::Position position;
 
 
   if (ofx_show_position == true)
   {
-    SGMLApplication::Location *location = new SGMLApplication::Location(entity_ptr, position);
-    cerr << "(Above message occurred on Line " << location->lineNumber << ", Column " << location->columnNumber << ")" << endl;
-    delete location;
+    SGMLApplication::Location location(entity_ptr, position);
+    cerr << "(Above message occurred on Line " << location.lineNumber << ", Column " << location.columnNumber << ")" << endl;
   }
 }
 
 /**
-   Prints a message to stdout, if the corresponding message OfxMsgType given in the parameters is enabled
+   Prints a message to stdout, if the corresponding message OfxMsgType given in the parameters is enabled.
+   While processing for a context which has a log callback, the message is queued for the callback instead.
 */
-int message_out(OfxMsgType error_type, const string message)
+int (message_out)(OfxMsgType error_type, const string &message)
 {
-
+  if (ofx_log_mask & OFX_LOG_ROUTED)
+  {
+    if (ofx_log_mask & (1 << error_type))
+    {
+      int line = -1;
+      int column = -1;
+      if (ofx_log_mask & LIBOFX_LOG_WITH_POSITION)
+      {
+        SGMLApplication::Location location(entity_ptr, position);
+        line = location.lineNumber;
+        column = location.columnNumber;
+      }
+      log_context->logMessage(error_type, message, line, column);
+    }
+    return 0;
+  }
 
   switch  (error_type)
   {
@@ -18,6 +18,12 @@
 #ifndef OFX_MESSAGES_H
 #define OFX_MESSAGES_H
 
+/* For OFX_DISABLE_DEBUG_MESSAGES: message_enabled() must be the same in
+   every file */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
 /** The OfxMsgType enum describe's the type of message being sent, so the
     application/user/library can decide if it will be printed to stdout */
 enum OfxMsgType
@@ -36,6 +42,109 @@ enum OfxMsgType
 };
 using namespace std;
 /// Message output function
-int message_out(OfxMsgType type, const string message);
+int message_out(OfxMsgType type, const string &message);
+
+extern "C"
+{
+  extern int ofx_PARSER_msg;
+  extern int ofx_DEBUG_msg;
+  extern int ofx_DEBUG1_msg;
+  extern int ofx_DEBUG2_msg;
+  extern int ofx_DEBUG3_msg;
+  extern int ofx_DEBUG4_msg;
+  extern int ofx_DEBUG5_msg;
+  extern int ofx_STATUS_msg;
+  extern int ofx_INFO_msg;
+  extern int ofx_WARNING_msg;
+  extern int ofx_ERROR_msg;
+}
+
+/**
+ * Levels wanted by the log callback of the context this thread is
+ * processing, as LIBOFX_LOG_* bits plus OFX_LOG_ROUTED; 0 if messages go
+ * to stderr.  Maintained by OfxLogScope.
+ */
+extern thread_local int ofx_log_mask;
+
+/** Set in ofx_log_mask when the messages go to a log callback, even if it wants none */
+#define OFX_LOG_ROUTED (1 << 30)
+
+class LibofxContext;
+
+/**
+ * \brief Sends the messages of the current thread to the log callback of
+ * a context, for as long as the object lives.
+ *
+ * Put one at the top of every entry point that processes data for a
+ * context.  Scopes may nest; the outermost one delivers the queued
+ * messages when it ends.
+ */
+class OfxLogScope
+{
+public:
+  OfxLogScope(LibofxContext *context);
+  ~OfxLogScope();
+private:
+  LibofxContext *_previous_context;
+  int _previous_mask;
+};
+
+/**
+ * Whether messages of the given type are currently printed, or delivered
+ * to the log callback of the current context.
+ *
+ * When configured with --disable-debug-messages, DEBUG* and PARSER
+ * messages are never printed, and since the type is a constant at every
+ * call site the compiler drops those messages altogether.
+ */
+inline bool message_enabled(OfxMsgType type)
+{
+#ifdef OFX_DISABLE_DEBUG_MESSAGES
+  if (type <= DEBUG5 || type == PARSER)
+    return false;
+#endif
+  if (ofx_log_mask != 0)
+    return (ofx_log_mask & (1 << type)) != 0;
+
+  switch (type)
+  {
+#ifndef OFX_DISABLE_DEBUG_MESSAGES
+  case DEBUG:
+    return ofx_DEBUG_msg;
+  case DEBUG1:
+    return ofx_DEBUG1_msg;
+  case DEBUG2:
+    return ofx_DEBUG2_msg;
+  case DEBUG3:
+    return ofx_DEBUG3_msg;
+  case DEBUG4:
+    return ofx_DEBUG4_msg;
+  case DEBUG5:
+    return ofx_DEBUG5_msg;
+  case PARSER:
+    return ofx_PARSER_msg;
+#endif
+  case STATUS:
+    return ofx_STATUS_msg;
+  case INFO:
+    return ofx_INFO_msg;
+  case WARNING:
+    return ofx_WARNING_msg;
+  case ERROR:
+    return ofx_ERROR_msg;
+  default:
+    return true; /* So that message_out() reports the unknown type */
+  }
+}
+
+/**
+ * Only build the message if it is going to be printed.
+ *
+ * Most messages are assembled with operator+ from several strings; this
+ * macro makes sure none of that happens for disabled message types.  The
+ * message argument must not have side effects.
+ */
+#define message_out(type, message) \
+  (message_enabled(type) ? (message_out)((type), (message)) : 0)
 
 #endif
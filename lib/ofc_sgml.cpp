@@ -31,14 +31,15 @@
 #include "ofx_utilities.hh"
 #include "messages.hh"
 #include "ofx_containers.hh"
+#include "probes.hh"
 #include "ofc_sgml.hh"
 
 using namespace std;
 
 
-extern SGMLApplication::OpenEntityPtr entity_ptr;
-extern SGMLApplication::Position position;
-extern OfxMainContainer * MainContainer;
+extern thread_local SGMLApplication::OpenEntityPtr entity_ptr;
+extern thread_local SGMLApplication::Position position;
+extern thread_local OfxMainContainer * MainContainer;
 
 /** \brief This object is driven by OpenSP as it parses the SGML from the ofx file(s)
  */
@@ -50,13 +51,47 @@ private:
   bool is_data_element; /**< If the SGML element contains data, this flag is raised */
   string incoming_data; /**< The raw data from the SGML data element */
   LibofxContext * libofx_context;
+  EventGenerator * event_generator;
 public:
-  OFCApplication (LibofxContext * p_libofx_context)
+  OFCApplication (LibofxContext * p_libofx_context, EventGenerator * p_event_generator)
   {
     MainContainer = NULL;
     curr_container_element = NULL;
     is_data_element = false;
     libofx_context = p_libofx_context;
+    event_generator = p_event_generator;
+  }
+  ~OFCApplication()
+  {
+    message_out(DEBUG, "Entering the OFCApplication's destructor");
+    if (libofx_context->aborted())
+    {
+      /* A callback stopped the parsing: free the containers still open */
+      while (curr_container_element != NULL)
+      {
+        OfxGenericContainer *parent = curr_container_element->getparent();
+        if (curr_container_element == MainContainer)
+        {
+          MainContainer = NULL;
+        }
+        delete curr_container_element;
+        curr_container_element = parent;
+      }
+      delete MainContainer;
+      MainContainer = NULL;
+    }
+  }
+
+  /** \brief A callback returned LIBOFX_ABORT: halts OpenSP, which may still send a few events until it stops.
+   */
+  bool stopped()
+  {
+    if (!libofx_context->aborted())
+    {
+      return false;
+    }
+    event_generator->halt();
+    return true;
   }
 
   /** \brief Callback: Start of an OFX element
@@ -65,8 +100,15 @@ public:
   */
   void startElement (const StartElementEvent & event)
   {
+    OfxStatsTimer timer(libofx_context->stats().container_ns);
+    if (stopped())
+    {
+      return;
+    }
+    libofx_context->stats().elements++;
     string identifier;
     CharStringtostring (event.gi, identifier);
+    OFX_PROBE1(element__start, identifier.c_str());
     message_out(PARSER, "startElement event received from OpenSP for element " + identifier);
 
     position = event.pos;
@@ -195,6 +237,7 @@ public:
     {
       /* The element was a data element.  OpenSP will call one or several data() callback with the data */
       message_out (PARSER, "Data element " + identifier + " found");
+      libofx_context->stats().data_elements++;
       /* There is a bug in OpenSP 1.3.4, which won't send endElement Event for some elements, and will instead send an error like "document type does not allow element "MESSAGE" here".  Incoming_data should be empty in such a case, but it will not be if the endElement event was skiped. So we empty it, so at least the last element has a chance of having valid data */
       if (incoming_data != "")
       {
@@ -210,11 +253,17 @@ public:
   */
   void endElement (const EndElementEvent & event)
   {
+    OfxStatsTimer timer(libofx_context->stats().container_ns);
+    if (stopped())
+    {
+      return;
+    }
     string identifier;
     bool end_element_for_data_element;
 
     CharStringtostring (event.gi, identifier);
     end_element_for_data_element = is_data_element;
+    OFX_PROBE1(element__end, identifier.c_str());
     message_out(PARSER, "endElement event received from OpenSP for element " + identifier);
 
     position = event.pos;
@@ -227,7 +276,7 @@ public:
     {
       if (end_element_for_data_element == true)
       {
-        incoming_data = strip_whitespace(incoming_data);
+        strip_whitespace(incoming_data);
 
         curr_container_element->add_attribute (identifier, incoming_data);
         message_out (PARSER, "endElement: Added data '" + incoming_data + "' from " + identifier + " to " + curr_container_element->type + " container_element");
@@ -248,10 +297,20 @@ public:
             /* The main container is a special case */
             tmp_container_element = curr_container_element;
             curr_container_element = curr_container_element->getparent ();
-            MainContainer->gen_event();
-            delete MainContainer;
-            MainContainer = NULL;
-            message_out (DEBUG, "Element " + identifier + " closed, MainContainer destroyed");
+            if (libofx_context->keptMainContainers() != NULL)
+            {
+              /* A pipeline: the events are generated later */
+              libofx_context->keptMainContainers()->push_back(MainContainer);
+              MainContainer = NULL;
+              message_out (DEBUG, "Element " + identifier + " closed, MainContainer kept");
+            }
+            else
+            {
+              MainContainer->gen_event();
+              delete MainContainer;
+              MainContainer = NULL;
+              message_out (DEBUG, "Element " + identifier + " closed, MainContainer destroyed");
+            }
           }
           else
           {
@@ -282,6 +341,11 @@ public:
   */
   void data (const DataEvent & event)
   {
+    OfxStatsTimer timer(libofx_context->stats().container_ns);
+    if (stopped())
+    {
+      return;
+    }
     string tmp;
     position = event.pos;
     AppendCharStringtostring (event.data, incoming_data);
@@ -358,12 +422,20 @@ int ofc_proc_sgml(LibofxContext * libofx_context, int argc, char * const* argv)
   message_out(DEBUG, argv[1]);
   message_out(DEBUG, argv[2]);
 
+  libofx_context->timezoneCache()->clear_memo();
+
+  unsigned long long sgml_start = stats_now_ns();
   ParserEventGeneratorKit parserKit;
   parserKit.setOption (ParserEventGeneratorKit::showOpenEntities);
   EventGenerator *egp =	parserKit.makeEventGenerator (argc, argv);
   egp->inhibitMessages (true);	/* Error output is handled by libofx not OpenSP */
-  OFCApplication *app = new OFCApplication(libofx_context);
+  OFCApplication *app = new OFCApplication(libofx_context, egp);
   unsigned nErrors = egp->run (*app); /* Begin parsing */
   delete egp;
+  delete app;
+  libofx_context->stats().sgml_parsing_ns += stats_now_ns() - sgml_start;
+
+  libofx_context->stats().date_cache_hits += libofx_context->timezoneCache()->memo_hits;
+  libofx_context->stats().date_cache_misses += libofx_context->timezoneCache()->memo_misses;
   return nErrors > 0;
 }
@@ -27,7 +27,7 @@ investment accounts.
 #include "ofx_containers.hh"
 #include "ofx_utilities.hh"
 
-extern OfxMainContainer * MainContainer;
+extern thread_local OfxMainContainer * MainContainer;
 
 /***************************************************************************
  *                      OfxAccountContainer                                *
@@ -72,7 +72,7 @@ OfxAccountContainer::~OfxAccountContainer()
       ofx_proc_account_cb (data);*/
 }
 
-void OfxAccountContainer::add_attribute(const string identifier, const string value)
+void OfxAccountContainer::add_attribute(const string &identifier, const string &value)
 {
   if ( identifier == "BANKID")
   {
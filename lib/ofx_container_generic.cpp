@@ -26,7 +26,7 @@
 #include "libofx.h"
 #include "ofx_containers.hh"
 
-extern OfxMainContainer * MainContainer;
+extern thread_local OfxMainContainer * MainContainer;
 
 OfxGenericContainer::OfxGenericContainer(LibofxContext *p_libofx_context)
 {
@@ -34,10 +34,12 @@ OfxGenericContainer::OfxGenericContainer(LibofxContext *p_libofx_context)
   type = "";
   tag_identifier = "";
   libofx_context = p_libofx_context;
+  libofx_context->stats().allocations++;
 }
 OfxGenericContainer::OfxGenericContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer)
 {
   libofx_context = p_libofx_context;
+  libofx_context->stats().allocations++;
   parentcontainer = para_parentcontainer;
   if (parentcontainer != NULL && parentcontainer->type == "DUMMY")
   {
@@ -47,6 +49,7 @@ OfxGenericContainer::OfxGenericContainer(LibofxContext *p_libofx_context, OfxGen
 OfxGenericContainer::OfxGenericContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer, string para_tag_identifier)
 {
   libofx_context = p_libofx_context;
+  libofx_context->stats().allocations++;
   parentcontainer = para_parentcontainer;
   tag_identifier = para_tag_identifier;
   if (parentcontainer != NULL && parentcontainer->type == "DUMMY")
@@ -54,7 +57,7 @@ OfxGenericContainer::OfxGenericContainer(LibofxContext *p_libofx_context, OfxGen
     message_out(DEBUG, "OfxGenericContainer(): The parent for this " + tag_identifier + " is a DummyContainer!");
   }
 }
-void OfxGenericContainer::add_attribute(const string identifier, const string value)
+void OfxGenericContainer::add_attribute(const string &identifier, const string &value)
 {
   /*If an attribute has made it all the way up to the Generic Container's add_attribute,
     we don't know what to do with it! */
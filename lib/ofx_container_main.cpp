@@ -26,10 +26,14 @@
 #include "messages.hh"
 #include "libofx.h"
 #include "ofx_containers.hh"
+#include "probes.hh"
 
 OfxMainContainer::OfxMainContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer, string para_tag_identifier):
   OfxGenericContainer(p_libofx_context, para_parentcontainer, para_tag_identifier)
 {
+  shared_securities = NULL;
+  generated_accounts = 0;
+  streaming = libofx_context->streamAccounts();
 
 //statement_tree_top=statement_tree.insert(statement_tree_top, NULL);
 //security_tree_top=security_tree.insert(security_tree_top, NULL);
@@ -38,20 +42,17 @@ OfxMainContainer::OfxMainContainer(LibofxContext *p_libofx_context, OfxGenericCo
 OfxMainContainer::~OfxMainContainer()
 {
   message_out(DEBUG, "Entering the main container's destructor");
-  tree<OfxGenericContainer *>::iterator tmp = security_tree.begin();
-
-  while (tmp != security_tree.end())
+  for (vector<OfxSecurityContainer *>::iterator tmp = securities.begin(); tmp != securities.end(); ++tmp)
   {
     message_out(DEBUG, "Deleting " + (*tmp)->type);
     delete (*tmp);
-    ++tmp;
   }
-  tmp = account_tree.begin();
-  while (tmp != account_tree.end())
+  for (vector<AccountRecord>::iterator tmp = accounts.begin(); tmp != accounts.end(); ++tmp)
   {
-    message_out(DEBUG, "Deleting " + (*tmp)->type);
-    delete (*tmp);
-    ++tmp;
+    message_out(DEBUG, "Deleting " + tmp->account->type);
+    delete tmp->account;
+    for (size_t i = 0; i < tmp->statements.size(); i++)
+      delete tmp->statements[i];
   }
 }
 int OfxMainContainer::add_container(OfxGenericContainer * container)
@@ -66,7 +67,10 @@ int OfxMainContainer::add_container(OfxGenericContainer * container)
 int OfxMainContainer::add_container(OfxSecurityContainer * container)
 {
   message_out(DEBUG, "OfxMainContainer::add_container, adding a security");
-  security_tree.insert(security_tree.begin(), container);
+  securities.push_back(container);
+  security_index[container->data.unique_id] = container;
+  /* Its events come before those of the accounts not generated yet */
+  streaming = false;
   return true;
 
 
@@ -75,49 +79,34 @@ int OfxMainContainer::add_container(OfxSecurityContainer * container)
 int OfxMainContainer::add_container(OfxAccountContainer * container)
 {
   message_out(DEBUG, "OfxMainContainer::add_container, adding an account");
-  if ( account_tree.size() == 0)
-  {
-    message_out(DEBUG, "OfxMainContainer::add_container, account is the first account");
-    account_tree.insert(account_tree.begin(), container);
-  }
-  else
-  {
-    message_out(DEBUG, "OfxMainContainer::add_container, account is not the first account");
-    tree<OfxGenericContainer *>::sibling_iterator tmp =  account_tree.begin();
-    tmp += (account_tree.number_of_siblings(tmp)); //Find last account
-    account_tree.insert_after(tmp, container);
-  }
+  accounts.push_back(AccountRecord());
+  accounts.back().account = container;
   return true;
 }
 
 int OfxMainContainer::add_container(OfxStatementContainer * container)
 {
   message_out(DEBUG, "OfxMainContainer::add_container, adding a statement");
-  tree<OfxGenericContainer *>::sibling_iterator tmp =  account_tree.begin();
-  //cerr<< "size="<<account_tree.size()<<"; num_sibblings="<<account_tree.number_of_siblings(tmp)<<endl;
-  tmp += (account_tree.number_of_siblings(tmp)); //Find last account
-
-  if (account_tree.is_valid(tmp))
+  if (!accounts.empty())
   {
-    message_out(DEBUG, "1: tmp is valid, Accounts are present");
-    tree<OfxGenericContainer *>::iterator child = account_tree.begin(tmp);
-    if (account_tree.number_of_children(tmp) != 0)
+    message_out(DEBUG, "1: Accounts are present");
+    accounts.back().statements.push_back(container);
+    container->add_account(&accounts.back().account->data);
+    /* The securities its transactions point to may come after it */
+    if (accounts.back().account->data.account_type_valid
+        && accounts.back().account->data.account_type == OfxAccountData::OFX_INVESTMENT)
+      streaming = false;
+    if (streaming)
     {
-      message_out(DEBUG, "There are already children for this account");
-      account_tree.insert(tmp.begin(), container);
-
-    }
-    else
-    {
-      message_out(DEBUG, "There are no children for this account");
-      account_tree.append_child(tmp, container);
+      /* The transactions of the account come before the end of its statement */
+      gen_account_events();
+      libofx_context->resume();
     }
-    container->add_account(&( ((OfxAccountContainer *)(*tmp))->data));
     return true;
   }
   else
   {
-    message_out(ERROR, "OfxMainContainer::add_container, no accounts are present (tmp is invalid)");
+    message_out(ERROR, "OfxMainContainer::add_container, no accounts are present");
     return false;
   }
 }
@@ -126,74 +115,96 @@ int OfxMainContainer::add_container(OfxTransactionContainer * container)
 {
   message_out(DEBUG, "OfxMainContainer::add_container, adding a transaction");
 
-  if ( account_tree.size() != 0)
+  if (!accounts.empty())
   {
-    tree<OfxGenericContainer *>::sibling_iterator tmp =  account_tree.begin();
-    //cerr<< "size="<<account_tree.size()<<"; num_sibblings="<<account_tree.number_of_siblings(tmp)<<endl;
-    tmp += (account_tree.number_of_siblings(tmp)); //Find last account
-    if (account_tree.is_valid(tmp))
-    {
-      message_out(DEBUG, "OfxMainContainer::add_container: tmp is valid, Accounts are present");
-      account_tree.append_child(tmp, container);
-      container->add_account(&(((OfxAccountContainer *)(*tmp))->data));
-      return true;
-    }
-    else
-    {
-      message_out(ERROR, "OfxMainContainer::add_container: tmp is invalid!");
-      return false;
-    }
+    message_out(DEBUG, "OfxMainContainer::add_container: Accounts are present; recording and destroying the transaction container");
+    container->add_account(&accounts.back().account->data);
+    accounts.back().transactions.push_back(OfxTransactionRecord(container->data, string_pool));
+    delete container;
+    return true;
   }
   else
   {
-    message_out(ERROR, "OfxMainContainer::add_container: the tree is empty!");
+    message_out(ERROR, "OfxMainContainer::add_container: no accounts are present!");
     return false;
   }
 }
 
 int  OfxMainContainer::gen_event()
 {
-  message_out(DEBUG, "Begin walking the trees of the main container to generate events");
-  tree<OfxGenericContainer *>::iterator tmp = security_tree.begin();
-  //cerr<<"security_tree.size(): "<<security_tree.size()<<endl;
-  int i = 0;
-  while (tmp != security_tree.end())
+  OFX_PROBE(gen__event__start);
+  message_out(DEBUG, "Begin generating the events of the main container");
+  /* The securities, then each account followed by its statements and its
+     transactions.  This is the order in which the events were generated
+     when they were kept in trees.  A callback returning
+     LIBOFX_SKIP_STATEMENT ends the loop it is in, up to the next account,
+     and LIBOFX_ABORT ends them all. */
+  libofx_context->resume();
+  for (vector<OfxSecurityContainer *>::reverse_iterator tmp = securities.rbegin(); tmp != securities.rend() && !libofx_context->skipping(); ++tmp)
   {
-    message_out(DEBUG, "Looping...");
-    //cerr <<i<<endl;
-    i++;
     (*tmp)->gen_event();
-    ++tmp;
   }
-  tmp = account_tree.begin();
-  //cerr<<account_tree.size()<<endl;
-  i = 0;
-  while (tmp != account_tree.end())
-  {
-    //cerr<< "i="<<i<<"; depth="<<account_tree.depth(tmp)<<endl;
-    i++;
-    (*tmp)->gen_event();
-    ++tmp;
-  }
-  message_out(DEBUG, "End walking the trees of the main container to generate events");
+  gen_account_events();
+  libofx_context->resume();
+  message_out(DEBUG, "End generating the events of the main container");
+  OFX_PROBE(gen__event__end);
 
   return true;
 }
 
+void OfxMainContainer::gen_account_events()
+{
+  for (; generated_accounts < accounts.size() && !libofx_context->aborted(); generated_accounts++)
+  {
+    AccountRecord *tmp = &accounts[generated_accounts];
+    libofx_context->resume();
+    tmp->account->gen_event();
+    for (vector<OfxStatementContainer *>::reverse_iterator statement = tmp->statements.rbegin(); statement != tmp->statements.rend() && !libofx_context->skipping(); ++statement)
+      (*statement)->gen_event();
+    for (vector<OfxTransactionRecord>::const_iterator transaction = tmp->transactions.begin(); transaction != tmp->transactions.end() && !libofx_context->skipping(); ++transaction)
+    {
+      /* As OfxTransactionContainer::gen_event() */
+      OfxTransactionData data;
+      transaction->restore(data, string_pool);
+      if (data.unique_id_valid == true)
+      {
+        data.security_data_ptr = find_security(data.unique_id);
+        if (data.security_data_ptr != NULL)
+        {
+          data.security_data_valid = true;
+        }
+      }
+      libofx_context->transactionCallback(data);
+    }
+    if (libofx_context->streamAccounts())
+    {
+      /* Nothing points to the records: don't keep the whole file */
+      vector<OfxTransactionRecord>().swap(tmp->transactions);
+    }
+  }
+}
+
 OfxSecurityData *  OfxMainContainer::find_security(string unique_id)
 {
   message_out(DEBUG, "OfxMainContainer::find_security() Begin.");
 
-  tree<OfxGenericContainer *>::sibling_iterator tmp = security_tree.begin();
-  OfxSecurityData * retval = NULL;
-  while (tmp != security_tree.end() && retval == NULL)
+  unordered_map<string, OfxSecurityContainer *>::const_iterator found = security_index.find(unique_id);
+  if (found == security_index.end())
+    return shared_securities != NULL ? shared_securities->find_security(unique_id) : NULL;
+  message_out(DEBUG, (string)"Security " + found->second->data.unique_id + " found.");
+  return &found->second->data;
+}
+
+void OfxMainContainer::adopt(LibofxContext *p_libofx_context, OfxMainContainer *p_shared_securities)
+{
+  libofx_context = p_libofx_context;
+  for (vector<OfxSecurityContainer *>::iterator tmp = securities.begin(); tmp != securities.end(); ++tmp)
+    (*tmp)->libofx_context = p_libofx_context;
+  for (vector<AccountRecord>::iterator tmp = accounts.begin(); tmp != accounts.end(); ++tmp)
   {
-    if (((OfxSecurityContainer*)(*tmp))->data.unique_id == unique_id)
-    {
-      message_out(DEBUG, (string)"Security " + ((OfxSecurityContainer*)(*tmp))->data.unique_id + " found.");
-      retval = &((OfxSecurityContainer*)(*tmp))->data;
-    }
-    ++tmp;
+    tmp->account->libofx_context = p_libofx_context;
+    for (size_t i = 0; i < tmp->statements.size(); i++)
+      tmp->statements[i]->libofx_context = p_libofx_context;
   }
-  return retval;
+  shared_securities = p_shared_securities;
 }
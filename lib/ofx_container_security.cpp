@@ -27,7 +27,7 @@
 #include "ofx_containers.hh"
 #include "ofx_utilities.hh"
 
-extern OfxMainContainer * MainContainer;
+extern thread_local OfxMainContainer * MainContainer;
 
 /***************************************************************************
  *                     OfxSecurityContainer                                *
@@ -42,7 +42,7 @@ OfxSecurityContainer::OfxSecurityContainer(LibofxContext *p_libofx_context, OfxG
 OfxSecurityContainer::~OfxSecurityContainer()
 {
 }
-void OfxSecurityContainer::add_attribute(const string identifier, const string value)
+void OfxSecurityContainer::add_attribute(const string &identifier, const string &value)
 {
   if (identifier == "UNIQUEID")
   {
@@ -66,12 +66,12 @@ void OfxSecurityContainer::add_attribute(const string identifier, const string v
   }
   else if (identifier == "UNITPRICE")
   {
-    data.unitprice = ofxamount_to_double(value);
+    data.unitprice = ofxamount_to_double(value, &data.unitprice_micros);
     data.unitprice_valid = true;
   }
   else if (identifier == "DTASOF")
   {
-    data.date_unitprice = ofxdate_to_time_t(value);
+    data.date_unitprice = ofxdate_to_time_t(value, libofx_context->timezoneCache());
     data.date_unitprice_valid = true;
   }
   else if (identifier == "CURDEF")
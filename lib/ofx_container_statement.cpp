@@ -27,7 +27,7 @@ credit cart statements, etc.
 #include "ofx_containers.hh"
 #include "ofx_utilities.hh"
 
-extern OfxMainContainer * MainContainer;
+extern thread_local OfxMainContainer * MainContainer;
 
 /***************************************************************************
  *                    OfxStatementContainer                                *
@@ -47,7 +47,7 @@ OfxStatementContainer::~OfxStatementContainer()
         transaction_queue.pop();
       }*/
 }
-void OfxStatementContainer::add_attribute(const string identifier, const string value)
+void OfxStatementContainer::add_attribute(const string &identifier, const string &value)
 {
   if (identifier == "CURDEF")
   {
@@ -61,12 +61,12 @@ void OfxStatementContainer::add_attribute(const string identifier, const string
   }
   else if (identifier == "DTSTART")
   {
-    data.date_start = ofxdate_to_time_t(value);
+    data.date_start = ofxdate_to_time_t(value, libofx_context->timezoneCache());
     data.date_start_valid = true;
   }
   else if (identifier == "DTEND")
   {
-    data.date_end = ofxdate_to_time_t(value);
+    data.date_end = ofxdate_to_time_t(value, libofx_context->timezoneCache());
     data.date_end_valid = true;
   }
   else
@@ -80,6 +80,7 @@ void OfxStatementContainer::add_balance(OfxBalanceContainer* ptr_balance_contain
   if (ptr_balance_container->tag_identifier == "LEDGERBAL")
   {
     data.ledger_balance = ptr_balance_container->amount;
+    data.ledger_balance_micros = ptr_balance_container->amount_micros;
     data.ledger_balance_valid = ptr_balance_container->amount_valid;
     data.ledger_balance_date = ptr_balance_container->date;
     data.ledger_balance_date_valid = ptr_balance_container->date_valid;
@@ -87,6 +88,7 @@ void OfxStatementContainer::add_balance(OfxBalanceContainer* ptr_balance_contain
   else if (ptr_balance_container->tag_identifier == "AVAILBAL")
   {
     data.available_balance = ptr_balance_container->amount;
+    data.available_balance_micros = ptr_balance_container->amount_micros;
     data.available_balance_valid = ptr_balance_container->amount_valid;
     data.available_balance_date = ptr_balance_container->date;
     data.available_balance_date_valid = ptr_balance_container->date_valid;
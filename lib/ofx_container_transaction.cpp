@@ -28,7 +28,7 @@
 #include "ofx_containers.hh"
 #include "ofx_utilities.hh"
 
-extern OfxMainContainer * MainContainer;
+extern thread_local OfxMainContainer * MainContainer;
 
 /***************************************************************************
  *                      OfxTransactionContainer                            *
@@ -94,22 +94,22 @@ int  OfxTransactionContainer::add_to_main_tree()
 }
 
 
-void OfxTransactionContainer::add_attribute(const string identifier, const string value)
+void OfxTransactionContainer::add_attribute(const string &identifier, const string &value)
 {
 
   if (identifier == "DTPOSTED")
   {
-    data.date_posted = ofxdate_to_time_t(value);
+    data.date_posted = ofxdate_to_time_t(value, libofx_context->timezoneCache());
     data.date_posted_valid = true;
   }
   else if (identifier == "DTUSER")
   {
-    data.date_initiated = ofxdate_to_time_t(value);
+    data.date_initiated = ofxdate_to_time_t(value, libofx_context->timezoneCache());
     data.date_initiated_valid = true;
   }
   else if (identifier == "DTAVAIL")
   {
-    data.date_funds_available = ofxdate_to_time_t(value);
+    data.date_funds_available = ofxdate_to_time_t(value, libofx_context->timezoneCache());
     data.date_funds_available_valid = true;
   }
   else if (identifier == "FITID")
@@ -174,7 +174,7 @@ OfxBankTransactionContainer::OfxBankTransactionContainer(LibofxContext *p_libofx
 {
   ;
 }
-void OfxBankTransactionContainer::add_attribute(const string identifier, const string value)
+void OfxBankTransactionContainer::add_attribute(const string &identifier, const string &value)
 {
   if ( identifier == "TRNTYPE")
   {
@@ -254,11 +254,13 @@ void OfxBankTransactionContainer::add_attribute(const string identifier, const s
   }//end TRANSTYPE
   else if (identifier == "TRNAMT")
   {
-    data.amount = ofxamount_to_double(value);
+    data.amount = ofxamount_to_double(value, &data.amount_micros);
     data.amount_valid = true;
     data.units = -data.amount;
+    data.units_micros = -data.amount_micros;
     data.units_valid = true;
     data.unitprice = 1.00;
+    data.unitprice_micros = 1000000;
     data.unitprice_valid = true;
   }
   else if (identifier == "CHECKNUM")
@@ -393,7 +395,7 @@ OfxInvestmentTransactionContainer::OfxInvestmentTransactionContainer(LibofxConte
   }
 }
 
-void OfxInvestmentTransactionContainer::add_attribute(const string identifier, const string value)
+void OfxInvestmentTransactionContainer::add_attribute(const string &identifier, const string &value)
 {
   if (identifier == "UNIQUEID")
   {
@@ -407,12 +409,12 @@ void OfxInvestmentTransactionContainer::add_attribute(const string identifier, c
   }
   else if (identifier == "UNITS")
   {
-    data.units = ofxamount_to_double(value);
+    data.units = ofxamount_to_double(value, &data.units_micros);
     data.units_valid = true;
   }
   else if (identifier == "UNITPRICE")
   {
-    data.unitprice = ofxamount_to_double(value);
+    data.unitprice = ofxamount_to_double(value, &data.unitprice_micros);
     data.unitprice_valid = true;
   }
   else if (identifier == "MKTVAL")
@@ -421,37 +423,37 @@ void OfxInvestmentTransactionContainer::add_attribute(const string identifier, c
   }
   else if (identifier == "TOTAL")
   {
-    data.amount = ofxamount_to_double(value);
+    data.amount = ofxamount_to_double(value, &data.amount_micros);
     data.amount_valid = true;
   }
   else if (identifier == "DTSETTLE")
   {
-    data.date_posted = ofxdate_to_time_t(value);
+    data.date_posted = ofxdate_to_time_t(value, libofx_context->timezoneCache());
     data.date_posted_valid = true;
   }
   else if (identifier == "DTTRADE")
   {
-    data.date_initiated = ofxdate_to_time_t(value);
+    data.date_initiated = ofxdate_to_time_t(value, libofx_context->timezoneCache());
     data.date_initiated_valid = true;
   }
   else if (identifier == "COMMISSION")
   {
-    data.commission = ofxamount_to_double(value);
+    data.commission = ofxamount_to_double(value, &data.commission_micros);
     data.commission_valid = true;
   }
   else if (identifier == "FEES")
   {
-    data.fees = ofxamount_to_double(value);
+    data.fees = ofxamount_to_double(value, &data.fees_micros);
     data.fees_valid = true;
   }
   else if (identifier == "OLDUNITS")
   {
-    data.oldunits = ofxamount_to_double(value);
+    data.oldunits = ofxamount_to_double(value, &data.oldunits_micros);
     data.oldunits_valid = true;
   }
   else if (identifier == "NEWUNITS")
   {
-    data.newunits = ofxamount_to_double(value);
+    data.newunits = ofxamount_to_double(value, &data.newunits_micros);
     data.newunits_valid = true;
   }
   else
@@ -20,9 +20,12 @@
  ***************************************************************************/
 #ifndef OFX_PROC_H
 #define OFX_PROC_H
+#include <string>
+#include <vector>
+#include <unordered_map>
 #include "libofx.h"
-#include "tree.hh"
 #include "context.hh"
+#include "ofx_transaction_record.hh"
 
 using namespace std;
 
@@ -50,7 +53,7 @@ public:
    \param identifier The name of the data element
    \param value The concatenated string of the data
   */
-  virtual void add_attribute(const string identifier, const string value);
+  virtual void add_attribute(const string &identifier, const string &value);
   /** \brief Generate libofx.h events.
    *
    gen_event will call the appropriate ofx_proc_XXX_cb defined in libofx.h if one is available.
@@ -77,7 +80,7 @@ class OfxDummyContainer: public OfxGenericContainer
 {
 public:
   OfxDummyContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer, string para_tag_identifier);
-  void add_attribute(const string identifier, const string value);
+  void add_attribute(const string &identifier, const string &value);
 };
 
 /** \brief A container to hold a OFX SGML element for which you want the parent to process it's data elements
@@ -89,7 +92,7 @@ class OfxPushUpContainer: public OfxGenericContainer
 public:
 
   OfxPushUpContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer, string para_tag_identifier);
-  void add_attribute(const string identifier, const string value);
+  void add_attribute(const string &identifier, const string &value);
 };
 
 /** \brief Represents the <STATUS> OFX SGML entity */
@@ -100,7 +103,7 @@ public:
 
   OfxStatusContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer, string para_tag_identifier);
   ~OfxStatusContainer();
-  void add_attribute(const string identifier, const string value);
+  void add_attribute(const string &identifier, const string &value);
 };
 
 /** \brief Represents the <BALANCE> OFX SGML entity
@@ -115,13 +118,14 @@ public:
   //char description[OFX_BALANCE_DESCRIPTION_LENGTH];
   //enum BalanceType{DOLLAR, PERCENT, NUMBER} balance_type;
   double amount; /**< Interpretation depends on balance_type */
+  long long amount_micros; /**< amount in millionths, see OfxTransactionData::amount_micros */
   int amount_valid;
   time_t date; /**< Effective date of the given balance */
   int date_valid;
 
   OfxBalanceContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer, string para_tag_identifier);
   ~OfxBalanceContainer();
-  void add_attribute(const string identifier, const string value);
+  void add_attribute(const string &identifier, const string &value);
 };
 
 /***************************************************************************
@@ -138,7 +142,7 @@ public:
 
   OfxStatementContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer, string para_tag_identifier);
   ~OfxStatementContainer();
-  void add_attribute(const string identifier, const string value);
+  void add_attribute(const string &identifier, const string &value);
   virtual int add_to_main_tree();
   virtual int gen_event();
   void add_account(OfxAccountData * account_data);
@@ -161,7 +165,7 @@ public:
 
   OfxAccountContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer, string para_tag_identifier);
   ~OfxAccountContainer();
-  void add_attribute(const string identifier, const string value);
+  void add_attribute(const string &identifier, const string &value);
   int add_to_main_tree();
   virtual int gen_event();
 private:
@@ -185,7 +189,7 @@ public:
 
   OfxSecurityContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer, string para_tag_identifier);
   ~OfxSecurityContainer();
-  void add_attribute(const string identifier, const string value);
+  void add_attribute(const string &identifier, const string &value);
   virtual int gen_event();
   virtual int add_to_main_tree();
 private:
@@ -205,7 +209,7 @@ public:
 
   OfxTransactionContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer, string para_tag_identifier);
   ~OfxTransactionContainer();
-  virtual void add_attribute(const string identifier, const string value);
+  virtual void add_attribute(const string &identifier, const string &value);
   void add_account(OfxAccountData * account_data);
 
   virtual int gen_event();
@@ -222,7 +226,7 @@ class OfxBankTransactionContainer: public OfxTransactionContainer
 {
 public:
   OfxBankTransactionContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer, string para_tag_identifier);
-  void add_attribute(const string identifier, const string value);
+  void add_attribute(const string &identifier, const string &value);
 };
 
 /** \brief  Represents a bank or credid card transaction.
@@ -234,7 +238,7 @@ class OfxInvestmentTransactionContainer: public OfxTransactionContainer
 public:
   OfxInvestmentTransactionContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer, string para_tag_identifier);
 
-  void add_attribute(const string identifier, const string value);
+  void add_attribute(const string &identifier, const string &value);
 };
 
 /***************************************************************************
@@ -242,7 +246,7 @@ public:
  ***************************************************************************/
 /** \brief The root container.  Created by the <OFX> OFX element or by the export functions.
  *
- The OfxMainContainer maintains trees of processed ofx data structures which can be used to generate events in the right order, and eventually export in OFX and QIF formats and even generate matching OFX querys.
+ The OfxMainContainer keeps the processed ofx data structures, which are used to generate events in the right order, and eventually export in OFX and QIF formats and even generate matching OFX querys.
 */
 class OfxMainContainer: public OfxGenericContainer
 {
@@ -256,9 +260,34 @@ public:
   int add_container(OfxSecurityContainer * container);
   int gen_event();
   OfxSecurityData * find_security(string unique_id);
+  /** Generate the events in another context, and look the securities not
+      found here up in another main container.  For the main containers
+      of the workers of ofx_proc_file_parallel(). */
+  void adopt(LibofxContext *p_libofx_context, OfxMainContainer *p_shared_securities);
 private:
-  tree<OfxGenericContainer *> security_tree;
-  tree<OfxGenericContainer *> account_tree;
+  /** Generate the events of the accounts not generated yet */
+  void gen_account_events();
+  /** An account, with the statements and transactions that followed it in the file */
+  struct AccountRecord
+  {
+    OfxAccountContainer *account;
+    vector<OfxStatementContainer *> statements; /**< In file order; their events are generated last one first */
+    vector<OfxTransactionRecord> transactions; /**< The containers are deleted once recorded */
+  };
+  /** In file order.  The statements and transactions belong to the last one. */
+  vector<AccountRecord> accounts;
+  /** The accounts before this one had their events generated, see LibofxContext::streamAccounts() */
+  size_t generated_accounts;
+  /** The events of each account are still generated at the end of its
+      statement: no security or investment account came yet */
+  bool streaming;
+  /** In file order; their events are generated last one first */
+  vector<OfxSecurityContainer *> securities;
+  /** The securities by unique_id; the last one wins if an id is repeated */
+  unordered_map<string, OfxSecurityContainer *> security_index;
+  /** The strings of the transactions */
+  OfxStringPool string_pool;
+  OfxMainContainer *shared_securities;
 };
 
 
@@ -32,7 +32,7 @@
 #include "ofx_utilities.hh"
 #include "ofx_containers.hh"
 
-extern OfxMainContainer * MainContainer;
+extern thread_local OfxMainContainer * MainContainer;
 
 /***************************************************************************
  *                         OfxDummyContainer                               *
@@ -42,9 +42,10 @@ OfxDummyContainer::OfxDummyContainer(LibofxContext *p_libofx_context, OfxGeneric
   OfxGenericContainer(p_libofx_context, para_parentcontainer, para_tag_identifier)
 {
   type = "DUMMY";
+  libofx_context->stats().dummy_containers++;
   message_out(INFO, "Created OfxDummyContainer to hold unsupported aggregate " + para_tag_identifier);
 }
-void OfxDummyContainer::add_attribute(const string identifier, const string value)
+void OfxDummyContainer::add_attribute(const string &identifier, const string &value)
 {
   message_out(DEBUG, "OfxDummyContainer for " + tag_identifier + " ignored a " + identifier + " (" + value + ")");
 }
@@ -59,7 +60,7 @@ OfxPushUpContainer::OfxPushUpContainer(LibofxContext *p_libofx_context, OfxGener
   type = "PUSHUP";
   message_out(DEBUG, "Created OfxPushUpContainer to hold aggregate " + tag_identifier);
 }
-void OfxPushUpContainer::add_attribute(const string identifier, const string value)
+void OfxPushUpContainer::add_attribute(const string &identifier, const string &value)
 {
   //message_out(DEBUG, "OfxPushUpContainer for "+tag_identifier+" will push up a "+identifier+" ("+value+") to a "+ parentcontainer->type + " container");
   if (parentcontainer)
@@ -92,7 +93,7 @@ OfxStatusContainer::~OfxStatusContainer()
     delete [] data.server_message;
 }
 
-void OfxStatusContainer::add_attribute(const string identifier, const string value)
+void OfxStatusContainer::add_attribute(const string &identifier, const string &value)
 {
   ErrorMsg error_msg;
 
@@ -147,6 +148,8 @@ void OfxStatusContainer::add_attribute(const string identifier, const string val
 OfxBalanceContainer::OfxBalanceContainer(LibofxContext *p_libofx_context, OfxGenericContainer *para_parentcontainer, string para_tag_identifier):
   OfxGenericContainer(p_libofx_context, para_parentcontainer, para_tag_identifier)
 {
+  amount = 0;
+  amount_micros = 0;
   amount_valid = false;
   date_valid = false;
   type = "BALANCE";
@@ -163,16 +166,16 @@ OfxBalanceContainer::~OfxBalanceContainer()
     message_out (ERROR, "I completed a " + type + " element, but I haven't found a suitable parent to save it");
   }
 }
-void OfxBalanceContainer::add_attribute(const string identifier, const string value)
+void OfxBalanceContainer::add_attribute(const string &identifier, const string &value)
 {
   if (identifier == "BALAMT")
   {
-    amount = ofxamount_to_double(value);
+    amount = ofxamount_to_double(value, &amount_micros);
     amount_valid = true;
   }
   else if (identifier == "DTASOF")
   {
-    date = ofxdate_to_time_t(value);
+    date = ofxdate_to_time_t(value, libofx_context->timezoneCache());
     date_valid = true;
   }
   else
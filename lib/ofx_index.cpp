@@ -0,0 +1,411 @@
+/***************************************************************************
+                          ofx_index.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Index of the statements of an OFX file, and processing of some of them
+ *
+ * A consolidated statement can hold hundreds of accounts.  The index
+ * records where each statement and the list of securities are in the
+ * file, so that libofx_proc_file_range() can hand only the selected ones
+ * to the parser: it copies the headers, the signon response and the
+ * selected aggregates, each in its message set, to a temporary file and
+ * processes that file with libofx_proc_file().
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "libofx.h"
+#include "messages.hh"
+#include "context.hh"
+#include "ofx_utilities.hh"
+#include "ofx_tag_scanner.hh"
+#include "ofx_index.hh"
+
+#ifdef OS_WIN32
+# include "win32.hh"
+# define fseeko _fseeki64
+#endif
+
+using namespace std;
+
+static const size_t INDEX_READ_SIZE = 65536;
+static const char INDEX_FILE_SUFFIX[] = ".idx";
+static const char INDEX_FILE_MAGIC[] = "LIBOFX-INDEX 2";
+
+/**
+ * \brief Builds an OfxIndex from the tags of a file
+ */
+class OfxIndexer: public OfxTagScanner
+{
+public:
+  OfxIndexer(OfxIndex &p_index);
+protected:
+  virtual void start_tag(const string &name, unsigned long long offset);
+  virtual void end_tag(const string &name, unsigned long long end_offset);
+  virtual void value(const string &name, string &text);
+private:
+  OfxIndex &index;
+  string message_set; /**< The last message set started */
+  string entry_element; /**< The element of the entry being scanned, if any */
+  OfxIndexEntry entry;
+  bool in_account;
+  OfxScannedAccount account;
+};
+
+OfxIndexer::OfxIndexer(OfxIndex &p_index): index(p_index)
+{
+  in_account = false;
+}
+
+void OfxIndexer::start_tag(const string &name, unsigned long long offset)
+{
+  if (!entry_element.empty())
+  {
+    if (!in_account && !entry.account_id_valid && account.start(name))
+      in_account = true;
+    return;
+  }
+
+  if (name.size() > 8 && name.compare(name.size() - 8, 8, "MSGSRSV1") == 0)
+  {
+    message_set = name;
+    if (name == "SIGNONMSGSRSV1")
+      index.signon_offset = offset;
+    return;
+  }
+
+  if (name == "STMTTRNRS")
+    entry.type = OFX_INDEX_BANK_STATEMENT;
+  else if (name == "CCSTMTTRNRS")
+    entry.type = OFX_INDEX_CREDITCARD_STATEMENT;
+  else if (name == "INVSTMTTRNRS")
+    entry.type = OFX_INDEX_INVESTMENT_STATEMENT;
+  else if (name == "SECLIST")
+    entry.type = OFX_INDEX_SECURITY_LIST;
+  else
+    return;
+  entry_element = name;
+  entry.offset = offset;
+  entry.length = 0;
+  entry.account_id[0] = '\0';
+  entry.account_id_valid = false;
+}
+
+void OfxIndexer::end_tag(const string &name, unsigned long long end_offset)
+{
+  if (entry_element.empty())
+  {
+    if (name == "SIGNONMSGSRSV1")
+      index.signon_length = end_offset - index.signon_offset;
+    else if (name == "OFX")
+      stop();
+    return;
+  }
+
+  if (in_account && account.end(name))
+  {
+    strncpy(entry.account_id, account.account_id().c_str(), OFX_ACCOUNT_ID_LENGTH - 1);
+    entry.account_id[OFX_ACCOUNT_ID_LENGTH - 1] = '\0';
+    entry.account_id_valid = true;
+    in_account = false;
+  }
+  else if (name == entry_element)
+  {
+    entry.length = end_offset - entry.offset;
+    index.entries.push_back(entry);
+    index.message_sets.push_back(message_set);
+    entry_element.clear();
+  }
+}
+
+void OfxIndexer::value(const string &name, string &text)
+{
+  if (in_account)
+    account.value(name, text);
+}
+
+/** Size and modification time of a file
+    @return false if the file can't be found */
+static bool file_status(const char *filename, unsigned long long &size, long long &mtime)
+{
+  struct stat status;
+  if (stat(filename, &status) != 0)
+    return false;
+  size = status.st_size;
+  mtime = status.st_mtime;
+  return true;
+}
+
+/** Writes an index file: to a temporary file first, renamed once
+    complete, so that it is never read half written */
+static bool write_index(const OfxIndex &index, const string &filename)
+{
+  string tmp_filename = filename + ".XXXXXX";
+  int tmp_file_fd = mkstemp(&tmp_filename[0]);
+  FILE *out = tmp_file_fd >= 0 ? fdopen(tmp_file_fd, "w") : NULL;
+  if (out == NULL)
+    return false;
+  fprintf(out, "%s\n%llu %lld %llu %llu %llu %llu\n", INDEX_FILE_MAGIC, index.file_size, index.file_mtime,
+          index.ofx_offset, index.signon_offset, index.signon_length,
+          (unsigned long long)index.entries.size());
+  for (size_t i = 0; i < index.entries.size(); i++)
+  {
+    const OfxIndexEntry &entry = index.entries[i];
+    fprintf(out, "%d %llu %llu %s %d %s\n", (int)entry.type, entry.offset, entry.length,
+            index.message_sets[i].c_str(), entry.account_id_valid, entry.account_id);
+  }
+  bool ok = ferror(out) == 0;
+  ok = fclose(out) == 0 && ok;
+#ifdef OS_WIN32
+  /* rename() doesn't replace an existing file */
+  if (ok)
+    remove(filename.c_str());
+#endif
+  ok = ok && rename(tmp_filename.c_str(), filename.c_str()) == 0;
+  if (!ok)
+    remove(tmp_filename.c_str());
+  return ok;
+}
+
+/** Reads an index file
+    @return false if it can't be read, if it doesn't have as many entries
+    as it says, or if it is not the index of the file of the given size
+    and time */
+static bool read_index(OfxIndex &index, const string &filename,
+                       unsigned long long file_size, long long file_mtime)
+{
+  FILE *in = fopen(filename.c_str(), "r");
+  if (in == NULL)
+    return false;
+  char line[256 + OFX_ACCOUNT_ID_LENGTH];
+  unsigned long long entry_count = 0;
+  bool ok = fgets(line, sizeof(line), in) != NULL &&
+            strncmp(line, INDEX_FILE_MAGIC, strlen(INDEX_FILE_MAGIC)) == 0 &&
+            fscanf(in, "%llu %lld %llu %llu %llu %llu\n", &index.file_size, &index.file_mtime,
+                   &index.ofx_offset, &index.signon_offset, &index.signon_length, &entry_count) == 6 &&
+            index.file_size == file_size && index.file_mtime == file_mtime;
+  while (ok && fgets(line, sizeof(line), in) != NULL)
+  {
+    OfxIndexEntry entry;
+    int type;
+    char message_set[64];
+    int account_start = 0;
+    if (sscanf(line, "%d %llu %llu %63s %d%n", &type, &entry.offset, &entry.length,
+               message_set, &entry.account_id_valid, &account_start) < 5 ||
+        type < OFX_INDEX_BANK_STATEMENT || type > OFX_INDEX_SECURITY_LIST ||
+        entry.offset + entry.length > file_size)
+    {
+      ok = false;
+      break;
+    }
+    entry.type = (OfxIndexEntryType)type;
+    if (line[account_start] == ' ')
+      account_start++;
+    string account_id = line + account_start;
+    account_id.erase(account_id.find_last_not_of("\r\n") + 1);
+    strncpy(entry.account_id, account_id.c_str(), OFX_ACCOUNT_ID_LENGTH - 1);
+    entry.account_id[OFX_ACCOUNT_ID_LENGTH - 1] = '\0';
+    index.entries.push_back(entry);
+    index.message_sets.push_back(message_set);
+  }
+  fclose(in);
+  return ok && index.entries.size() == entry_count;
+}
+
+LibofxIndexPtr libofx_index_file(LibofxContextPtr ctx, const char *p_filename, int use_index_file)
+{
+  LibofxContext *libofx_context = (LibofxContext *)ctx;
+  OfxLogScope log_scope(libofx_context);
+  OfxIndex *index = new OfxIndex();
+
+  unsigned long long file_size;
+  long long file_mtime;
+  if (p_filename == NULL || !file_status(p_filename, file_size, file_mtime))
+  {
+    message_out(ERROR, "libofx_index_file(): Unable to open the input file " + string(p_filename != NULL ? p_filename : ""));
+    delete index;
+    return NULL;
+  }
+  string index_filename = string(p_filename) + INDEX_FILE_SUFFIX;
+  if (use_index_file)
+  {
+    if (read_index(*index, index_filename, file_size, file_mtime))
+    {
+      message_out(DEBUG, "libofx_index_file(): Read the index " + index_filename);
+      return index;
+    }
+    *index = OfxIndex();
+  }
+
+  FILE *input_file = fopen(p_filename, "rb");
+  if (input_file == NULL)
+  {
+    message_out(ERROR, "libofx_index_file(): Unable to open the input file " + string(p_filename));
+    delete index;
+    return NULL;
+  }
+  index->file_size = file_size;
+  index->file_mtime = file_mtime;
+  OfxIndexer indexer(*index);
+  vector<char> buffer(INDEX_READ_SIZE);
+  size_t read_size;
+  while ((read_size = fread(&buffer[0], 1, buffer.size(), input_file)) > 0)
+  {
+    libofx_context->stats().bytes_read += read_size;
+    if (!indexer.feed(&buffer[0], read_size))
+      break;
+  }
+  fclose(input_file);
+
+  if (!indexer.found_ofx())
+  {
+    message_out(ERROR, "libofx_index_file(): No <OFX> element in " + string(p_filename));
+    delete index;
+    return NULL;
+  }
+  index->ofx_offset = indexer.ofx_offset();
+
+  if (use_index_file && !write_index(*index, index_filename))
+    message_out(WARNING, "libofx_index_file(): Unable to write the index " + index_filename);
+  return index;
+}
+
+int libofx_index_count(LibofxIndexPtr index)
+{
+  return ((OfxIndex *)index)->entries.size();
+}
+
+const struct OfxIndexEntry *libofx_index_entry(LibofxIndexPtr index, int i)
+{
+  OfxIndex *ofx_index = (OfxIndex *)index;
+  if (i < 0 || i >= (int)ofx_index->entries.size())
+    return NULL;
+  return &ofx_index->entries[i];
+}
+
+void libofx_free_index(LibofxIndexPtr index)
+{
+  delete (OfxIndex *)index;
+}
+
+/** Copies length bytes at offset of the input file to the output file */
+static bool copy_range(FILE *in, FILE *out, unsigned long long offset, unsigned long long length)
+{
+  if (fseeko(in, offset, SEEK_SET) != 0)
+    return false;
+  char buffer[INDEX_READ_SIZE];
+  while (length > 0)
+  {
+    size_t size = length < sizeof(buffer) ? length : sizeof(buffer);
+    if (fread(buffer, 1, size, in) != size || fwrite(buffer, 1, size, out) != size)
+      return false;
+    length -= size;
+  }
+  return true;
+}
+
+bool ofx_write_range_file(const char *p_filename, const OfxIndex &index, const vector<int> &selected,
+                          char *tmp_filename, unsigned int size)
+{
+  FILE *input_file = fopen(p_filename, "rb");
+  if (input_file == NULL)
+  {
+    message_out(ERROR, "ofx_write_range_file(): Unable to open the input file " + string(p_filename));
+    return false;
+  }
+  mkTempFileName("libofxtmpXXXXXX", tmp_filename, size);
+  int tmp_file_fd = mkstemp(tmp_filename);
+  FILE *tmp_file = tmp_file_fd >= 0 ? fdopen(tmp_file_fd, "wb") : NULL;
+  if (tmp_file == NULL)
+  {
+    message_out(ERROR, "ofx_write_range_file(): Unable to create a temp file at " + string(tmp_filename));
+    fclose(input_file);
+    return false;
+  }
+
+  bool ok = copy_range(input_file, tmp_file, 0, index.ofx_offset);
+  fputs("<OFX>\n", tmp_file);
+  if (ok && index.signon_length > 0)
+    ok = copy_range(input_file, tmp_file, index.signon_offset, index.signon_length);
+  string message_set;
+  for (size_t i = 0; i < selected.size() && ok; i++)
+  {
+    if (index.message_sets[selected[i]] != message_set)
+    {
+      if (!message_set.empty())
+        fprintf(tmp_file, "\n</%s>", message_set.c_str());
+      message_set = index.message_sets[selected[i]];
+      fprintf(tmp_file, "\n<%s>\n", message_set.c_str());
+    }
+    const OfxIndexEntry &entry = index.entries[selected[i]];
+    ok = copy_range(input_file, tmp_file, entry.offset, entry.length);
+  }
+  if (!message_set.empty())
+    fprintf(tmp_file, "\n</%s>", message_set.c_str());
+  fputs("\n</OFX>\n", tmp_file);
+  fclose(input_file);
+  ok = fclose(tmp_file) == 0 && ok;
+  if (!ok)
+  {
+    message_out(ERROR, "ofx_write_range_file(): Unable to copy the statements of " + string(p_filename));
+    remove(tmp_filename);
+  }
+  return ok;
+}
+
+int libofx_proc_file_range(LibofxContextPtr ctx, const char *p_filename, LibofxIndexPtr index,
+                           const int *entries, int count)
+{
+  LibofxContext *libofx_context = (LibofxContext *)ctx;
+  const OfxIndex &ofx_index = *(const OfxIndex *)index;
+  char tmp_filename[256];
+
+  /* In the order of the file, which is the order of the message sets in the DTD */
+  vector<int> selected;
+  for (int i = 0; i < count; i++)
+  {
+    if (entries[i] >= 0 && entries[i] < (int)ofx_index.entries.size())
+      selected.push_back(entries[i]);
+  }
+  sort(selected.begin(), selected.end());
+  selected.erase(unique(selected.begin(), selected.end()), selected.end());
+
+  {
+    OfxLogScope log_scope(libofx_context);
+    unsigned long long file_size;
+    long long file_mtime;
+    if (p_filename == NULL || !file_status(p_filename, file_size, file_mtime))
+    {
+      message_out(ERROR, "libofx_proc_file_range(): Unable to open the input file " + string(p_filename != NULL ? p_filename : ""));
+      return -1;
+    }
+    if (file_size != ofx_index.file_size || file_mtime != ofx_index.file_mtime)
+    {
+      message_out(ERROR, "libofx_proc_file_range(): " + string(p_filename) + " changed since it was indexed");
+      return -1;
+    }
+    if (!ofx_write_range_file(p_filename, ofx_index, selected, tmp_filename, sizeof(tmp_filename)))
+      return -1;
+  }
+
+  int retval = libofx_proc_file(ctx, tmp_filename, OFX);
+  if (remove(tmp_filename) != 0)
+  {
+    OfxLogScope log_scope(libofx_context);
+    message_out(ERROR, "libofx_proc_file_range(): Error deleting temporary file " + string(tmp_filename));
+  }
+  return retval;
+}
@@ -0,0 +1,54 @@
+/***************************************************************************
+                          ofx_index.hh
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Index of the statements of an OFX file, see libofx_index_file()
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef OFX_INDEX_H
+#define OFX_INDEX_H
+
+#include <string>
+#include <vector>
+#include "libofx.h"
+
+using namespace std;
+
+/**
+ * \brief The index behind a LibofxIndexPtr
+ */
+struct OfxIndex
+{
+  unsigned long long file_size; /**< Of the indexed file, to tell if it changed */
+  long long file_mtime;
+  unsigned long long ofx_offset; /**< Of the <OFX> tag: the headers are before it */
+  unsigned long long signon_offset;
+  unsigned long long signon_length; /**< 0 if the file has no SIGNONMSGSRSV1 */
+  vector<OfxIndexEntry> entries;
+  vector<string> message_sets; /**< The message set of each entry, such as BANKMSGSRSV1 */
+};
+
+/**
+ * \brief Writes a temporary OFX file holding some entries of an indexed file
+ *
+ * The temporary file has the headers and the signon response of the
+ * file, and the selected entries, each in its message set.
+ *
+ * @param selected numbers of the entries, in increasing order
+ * @param tmp_filename receives the name of the temporary file, which the
+ caller removes
+ * @return false if the file couldn't be written; there is no temporary
+ file then.
+ */
+bool ofx_write_range_file(const char *p_filename, const OfxIndex &index, const vector<int> &selected,
+                          char *tmp_filename, unsigned int size);
+
+#endif
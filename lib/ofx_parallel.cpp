@@ -0,0 +1,206 @@
+/***************************************************************************
+                          ofx_parallel.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Parsing the statements of an OFX file on several threads
+ *
+ * The file is indexed as by libofx_index_file(), and each worker parses
+ * a temporary file holding the headers, the signon response and its
+ * statements, as libofx_proc_file_range() does.  The workers keep their
+ * main container at the end of the <OFX> element instead of generating
+ * its events, and record the status events.  Once they are all done,
+ * the calling thread generates the events of the main containers in the
+ * order of the file, with the callbacks of the application.
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "libofx.h"
+#include "messages.hh"
+#include "context.hh"
+#include "ofx_preproc.hh"
+#include "ofx_containers.hh"
+#include "ofx_index.hh"
+#include "ofx_parallel.hh"
+
+using namespace std;
+
+/** A status event of a worker, to be generated by the calling thread */
+struct OfxStatusRecord
+{
+  OfxStatusData data;
+  string server_message; /**< data.server_message is freed after the callback */
+};
+
+/** The statements a worker parses, and what it kept of them */
+struct OfxParallelJob
+{
+  vector<int> entries; /**< In the index */
+  LibofxContext context;
+  vector<OfxMainContainer *> main_containers;
+  vector<OfxStatusRecord> statuses;
+  bool done;
+};
+
+static int record_status(const struct OfxStatusData data, void *job)
+{
+  vector<OfxStatusRecord> &statuses = ((OfxParallelJob *)job)->statuses;
+  statuses.push_back(OfxStatusRecord());
+  statuses.back().data = data;
+  if (data.server_message_valid)
+    statuses.back().server_message = data.server_message;
+  return 0;
+}
+
+static void run_job(const char *p_filename, const OfxIndex *index, OfxParallelJob *job)
+{
+  OfxLogScope log_scope(&job->context);
+  char tmp_filename[256];
+  if (!ofx_write_range_file(p_filename, *index, job->entries, tmp_filename, sizeof(tmp_filename)))
+    return;
+  job->context.setCurrentFileType(OFX);
+  ofx_proc_file(&job->context, tmp_filename);
+  if (remove(tmp_filename) != 0)
+    message_out(ERROR, "ofx_proc_file_parallel(): Error deleting temporary file " + string(tmp_filename));
+  job->done = true;
+}
+
+bool ofx_proc_file_parallel(LibofxContext *libofx_context, const char *p_filename)
+{
+  OfxIndex *index = (OfxIndex *)libofx_index_file(libofx_context, p_filename, false);
+  if (index == NULL)
+    return false;
+
+  /* Split the statements in contiguous groups of about the same size */
+  vector<int> statements;
+  vector<int> security_lists;
+  unsigned long long statement_bytes = 0;
+  for (size_t i = 0; i < index->entries.size(); i++)
+  {
+    if (index->entries[i].type == OFX_INDEX_SECURITY_LIST)
+      security_lists.push_back(i);
+    else
+    {
+      statements.push_back(i);
+      statement_bytes += index->entries[i].length;
+    }
+  }
+  if (statements.size() < 2)
+  {
+    libofx_free_index(index);
+    return false;
+  }
+  size_t groups = libofx_context->workerThreads();
+  if (groups > statements.size())
+    groups = statements.size();
+  message_out(INFO, "ofx_proc_file_parallel(): Parsing the statements of " + string(p_filename) + " on " + to_string(groups) + " threads");
+
+  vector<OfxParallelJob *> jobs;
+  unsigned long long group_bytes = 0;
+  for (size_t i = 0; i < statements.size(); i++)
+  {
+    if (jobs.empty() || (group_bytes * groups >= statement_bytes * jobs.size() && jobs.size() < groups))
+      jobs.push_back(new OfxParallelJob());
+    jobs.back()->entries.push_back(statements[i]);
+    group_bytes += index->entries[statements[i]].length;
+  }
+  OfxParallelJob *securities_job = NULL;
+  if (!security_lists.empty())
+  {
+    securities_job = new OfxParallelJob();
+    securities_job->entries = security_lists;
+    jobs.push_back(securities_job);
+  }
+
+  /* The workers only read the environment */
+  ofx_set_opensp_environment();
+  vector<thread> threads;
+  for (size_t j = 0; j < jobs.size(); j++)
+  {
+    OfxParallelJob *job = jobs[j];
+    job->done = false;
+    job->context.setDtdDir(libofx_context->dtdDir());
+    job->context.shareLogCallback(*libofx_context);
+    job->context.setStatusCallback(record_status, job);
+    job->context.keepMainContainers(&job->main_containers);
+    threads.push_back(thread(run_job, p_filename, index, job));
+  }
+  bool done = true;
+  for (size_t j = 0; j < jobs.size(); j++)
+  {
+    threads[j].join();
+    done = done && jobs[j]->done;
+  }
+
+  if (done)
+  {
+    for (size_t j = 0; j < jobs.size(); j++)
+      add_stats(libofx_context->stats(), jobs[j]->context.stats());
+
+    /* Timed as the events generated during a parse on one thread, which
+       callback_ns is a part of */
+    OfxStatsTimer sgml_timer(libofx_context->stats().sgml_parsing_ns);
+    OfxStatsTimer container_timer(libofx_context->stats().container_ns);
+
+    /* The status events, which come during the parse: the signon
+       response is in the file of every worker, but only reported once */
+    for (size_t j = 0; j < jobs.size(); j++)
+    {
+      for (size_t s = 0; s < jobs[j]->statuses.size(); s++)
+      {
+        OfxStatusRecord &status = jobs[j]->statuses[s];
+        if (j > 0 && strcmp(status.data.ofx_element_name, "SONRS") == 0)
+          continue;
+        if (status.data.server_message_valid)
+          status.data.server_message = (char *)status.server_message.c_str();
+        libofx_context->statusCallback(status.data);
+      }
+    }
+
+    /* The securities first, as from a single main container */
+    OfxMainContainer *securities = NULL;
+    if (securities_job != NULL && !securities_job->main_containers.empty())
+    {
+      securities = securities_job->main_containers.front();
+      securities->adopt(libofx_context, NULL);
+      if (!libofx_context->aborted())
+        securities->gen_event();
+    }
+    for (size_t j = 0; j < jobs.size(); j++)
+    {
+      for (size_t c = 0; c < jobs[j]->main_containers.size(); c++)
+      {
+        OfxMainContainer *container = jobs[j]->main_containers[c];
+        if (container == securities)
+          continue;
+        container->adopt(libofx_context, securities);
+        if (!libofx_context->aborted())
+          container->gen_event();
+      }
+    }
+  }
+  else
+  {
+    message_out(ERROR, "ofx_proc_file_parallel(): A worker failed, parsing " + string(p_filename) + " on one thread");
+  }
+
+  for (size_t j = 0; j < jobs.size(); j++)
+  {
+    for (size_t c = 0; c < jobs[j]->main_containers.size(); c++)
+      delete jobs[j]->main_containers[c];
+    delete jobs[j];
+  }
+  libofx_free_index(index);
+  return done;
+}
@@ -0,0 +1,36 @@
+/***************************************************************************
+                          ofx_parallel.hh
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Parsing the statements of an OFX file on several threads
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef OFX_PARALLEL_H
+#define OFX_PARALLEL_H
+
+#include "context.hh"
+
+/**
+ * \brief Processes an OFX file with the worker threads of the context
+ *
+ * The statements of the file are split in as many contiguous groups as
+ * there are threads, and each group is parsed on its own thread, with
+ * its own context and its own main container.  The SECLIST is parsed on
+ * a thread of its own.  The events are then generated on the calling
+ * thread, in the order of the file.
+ *
+ * @return false if the file was not processed, because it has less than
+ two statements or couldn't be indexed; ofx_proc_file() should then
+ process it.
+ */
+bool ofx_proc_file_parallel(LibofxContext *libofx_context, const char *p_filename);
+
+#endif
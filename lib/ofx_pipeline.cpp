@@ -0,0 +1,262 @@
+/***************************************************************************
+                          ofx_pipeline.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Parsing an OFX file while the events are used
+ *
+ * The parse, the containers and the generation of the events run on a
+ * thread of their own, whose context queues the events in a fixed size
+ * ring.  The thread that created the OfxPipeline takes them from the
+ * ring: ofx_proc_file_pipelined() to call the callbacks of the
+ * application with them, ofx::Reader to hand them to the application.
+ * Until the first security or investment account, the events of each
+ * account are generated as soon as its statement ends, so that the
+ * events of a statement are used while the next ones are parsed.
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <chrono>
+#include <string>
+#include "libofx.h"
+#include "messages.hh"
+#include "ofx_preproc.hh"
+#include "ofx_containers.hh"
+#include "ofx_pipeline.hh"
+
+/** Yields for a while, then sleeps: the other thread may be busy for long */
+static void wait_for_other_thread(unsigned int &spins)
+{
+  if (++spins < 64)
+    this_thread::yield();
+  else
+    this_thread::sleep_for(chrono::microseconds(50));
+}
+
+OfxEventQueue::OfxEventQueue()
+  : _head(0)
+  , _tail(0)
+{
+}
+
+OfxPipelineEvent &OfxEventQueue::back()
+{
+  unsigned long tail = _tail.load(memory_order_relaxed);
+  for (unsigned int spins = 0; tail - _head.load(memory_order_acquire) >= CAPACITY; )
+    wait_for_other_thread(spins);
+  return _slots[tail % CAPACITY];
+}
+
+OfxPipelineEvent &OfxEventQueue::front()
+{
+  unsigned long head = _head.load(memory_order_relaxed);
+  for (unsigned int spins = 0; _tail.load(memory_order_acquire) == head; )
+    wait_for_other_thread(spins);
+  return _slots[head % CAPACITY];
+}
+
+OfxPipeline::OfxPipeline(LibofxContext *libofx_context, const char *p_filename, LibofxFileFormat file_type)
+  : aborted(false)
+  , returned(false)
+  , ended(false)
+{
+  context.setDtdDir(libofx_context->dtdDir());
+  context.shareLogCallback(*libofx_context);
+  context.setCurrentFileType(file_type);
+  context.setStatusCallback(queue_status, this);
+  context.setSecurityCallback(queue_security, this);
+  context.setAccountCallback(queue_account, this);
+  context.setStatementCallback(queue_statement, this);
+  context.setTransactionCallback(queue_transaction, this);
+  context.keepMainContainers(&main_containers);
+  context.setStreamAccounts(file_type == OFX);
+  message_out(INFO, string("OfxPipeline: Parsing ") + p_filename + " on another thread");
+  /* The parsing thread only reads the environment */
+  ofx_set_opensp_environment();
+  parser = thread(run, this, string(p_filename));
+}
+
+OfxPipeline::~OfxPipeline()
+{
+  abort();
+  parser.join();
+  for (size_t c = 0; c < main_containers.size(); c++)
+    delete main_containers[c];
+}
+
+OfxPipelineEvent *OfxPipeline::next()
+{
+  if (returned)
+  {
+    queue.pop();
+    returned = false;
+  }
+  while (!ended)
+  {
+    OfxPipelineEvent &event = queue.front();
+    if (event.type == OfxPipelineEvent::END)
+    {
+      queue.pop();
+      ended = true;
+    }
+    else if (aborted.load(memory_order_relaxed))
+    {
+      /* Make room for the parsing thread until it notices */
+      queue.pop();
+    }
+    else
+    {
+      returned = true;
+      return &event;
+    }
+  }
+  return NULL;
+}
+
+void OfxPipeline::abort()
+{
+  aborted = true;
+  while (next() != NULL)
+    ;
+}
+
+void OfxPipeline::run(OfxPipeline *pipeline, string filename)
+{
+  {
+    OfxLogScope log_scope(&pipeline->context);
+    ofx_proc_file(&pipeline->context, filename.c_str());
+    /* The events not generated yet, timed as at the end of the <OFX> element */
+    OfxStatsTimer sgml_timer(pipeline->context.stats().sgml_parsing_ns);
+    OfxStatsTimer container_timer(pipeline->context.stats().container_ns);
+    for (size_t c = 0; c < pipeline->main_containers.size() && !pipeline->context.aborted(); c++)
+      pipeline->main_containers[c]->gen_event();
+  }
+  pipeline->queue.back().type = OfxPipelineEvent::END;
+  pipeline->queue.push();
+}
+
+/** The slot of the next event, or NULL if the pipeline was aborted */
+OfxPipelineEvent *OfxPipeline::next_event(void *pipeline, OfxPipelineEvent::Type type)
+{
+  /* Acquire: the consumer is done with the events it had before it
+     aborted, and the containers they point to may be deleted */
+  if (((OfxPipeline *)pipeline)->aborted.load(memory_order_acquire))
+    return NULL;
+  OfxPipelineEvent *event = &((OfxPipeline *)pipeline)->queue.back();
+  event->type = type;
+  return event;
+}
+
+int OfxPipeline::queue_event(void *pipeline)
+{
+  ((OfxPipeline *)pipeline)->queue.push();
+  return 0;
+}
+
+int OfxPipeline::queue_status(const struct OfxStatusData data, void *pipeline)
+{
+  OfxPipelineEvent *event = next_event(pipeline, OfxPipelineEvent::STATUS);
+  if (event == NULL)
+    return LIBOFX_ABORT;
+  event->status = data;
+  if (data.server_message_valid)
+  {
+    /* data.server_message is freed after the callback */
+    event->server_message = data.server_message;
+    event->status.server_message = (char *)event->server_message.c_str();
+  }
+  return queue_event(pipeline);
+}
+
+int OfxPipeline::queue_security(const struct OfxSecurityData data, void *pipeline)
+{
+  OfxPipelineEvent *event = next_event(pipeline, OfxPipelineEvent::SECURITY);
+  if (event == NULL)
+    return LIBOFX_ABORT;
+  event->security = data;
+  return queue_event(pipeline);
+}
+
+int OfxPipeline::queue_account(const struct OfxAccountData data, void *pipeline)
+{
+  OfxPipelineEvent *event = next_event(pipeline, OfxPipelineEvent::ACCOUNT);
+  if (event == NULL)
+    return LIBOFX_ABORT;
+  event->account = data;
+  return queue_event(pipeline);
+}
+
+int OfxPipeline::queue_statement(const struct OfxStatementData data, void *pipeline)
+{
+  OfxPipelineEvent *event = next_event(pipeline, OfxPipelineEvent::STATEMENT);
+  if (event == NULL)
+    return LIBOFX_ABORT;
+  event->statement = data;
+  return queue_event(pipeline);
+}
+
+int OfxPipeline::queue_transaction(const struct OfxTransactionData data, void *pipeline)
+{
+  OfxPipelineEvent *event = next_event(pipeline, OfxPipelineEvent::TRANSACTION);
+  if (event == NULL)
+    return LIBOFX_ABORT;
+  event->transaction = data;
+  return queue_event(pipeline);
+}
+
+void ofx_proc_file_pipelined(LibofxContext *libofx_context, const char *p_filename)
+{
+  OfxPipeline *pipeline = new OfxPipeline(libofx_context, p_filename, OFX);
+  struct LibofxStats stats = libofx_context->stats();
+
+  /* As OfxMainContainer::gen_event(): LIBOFX_SKIP_STATEMENT lasts until
+     the next account, or the end of the securities */
+  OfxPipelineEvent::Type previous = OfxPipelineEvent::END;
+  OfxPipelineEvent *event;
+  while (!libofx_context->aborted() && (event = pipeline->next()) != NULL)
+  {
+    switch (event->type)
+    {
+    case OfxPipelineEvent::STATUS:
+      libofx_context->statusCallback(event->status);
+      libofx_context->resume();
+      break;
+    case OfxPipelineEvent::SECURITY:
+      if (previous != OfxPipelineEvent::SECURITY)
+        libofx_context->resume();
+      if (!libofx_context->skipping())
+        libofx_context->securityCallback(event->security);
+      break;
+    case OfxPipelineEvent::ACCOUNT:
+      libofx_context->resume();
+      libofx_context->accountCallback(event->account);
+      break;
+    case OfxPipelineEvent::STATEMENT:
+      if (!libofx_context->skipping())
+        libofx_context->statementCallback(event->statement);
+      break;
+    case OfxPipelineEvent::TRANSACTION:
+      if (!libofx_context->skipping())
+        libofx_context->transactionCallback(event->transaction);
+      break;
+    default:
+      break;
+    }
+    previous = event->type;
+  }
+  pipeline->abort();
+  libofx_context->resume();
+
+  /* The statistics are those of the parsing thread, which counts the
+     events, with the time spent in the callbacks here */
+  unsigned long long callback_ns = libofx_context->stats().callback_ns - stats.callback_ns;
+  libofx_context->stats() = stats;
+  add_stats(libofx_context->stats(), pipeline->stats(callback_ns));
+  delete pipeline;
+}
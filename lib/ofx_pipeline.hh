@@ -0,0 +1,146 @@
+/***************************************************************************
+                          ofx_pipeline.hh
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Parsing an OFX file while the events are used
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef OFX_PIPELINE_H
+#define OFX_PIPELINE_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "libofx.h"
+#include "context.hh"
+
+using namespace std;
+
+class OfxMainContainer;
+
+/** An event generated by the parsing thread */
+struct OfxPipelineEvent
+{
+  enum Type { STATUS, SECURITY, ACCOUNT, STATEMENT, TRANSACTION, END } type;
+  union
+  {
+    struct OfxStatusData status;
+    struct OfxSecurityData security;
+    struct OfxAccountData account;
+    struct OfxStatementData statement;
+    struct OfxTransactionData transaction;
+  };
+  string server_message; /**< Where status.server_message points */
+};
+
+/**
+ * \brief Fixed size, lock free, single producer single consumer ring of
+ * events.
+ *
+ * The producer fills the slot returned by back() in place, then push()es
+ * it; the consumer reads front(), then pop()s it.  Both wait while the
+ * ring is full or empty, which keeps the parse from getting far ahead of
+ * a slow consumer.
+ */
+class OfxEventQueue
+{
+public:
+  OfxEventQueue();
+
+  OfxPipelineEvent &back();
+  void push()
+  {
+    _tail.store(_tail.load(memory_order_relaxed) + 1, memory_order_release);
+  };
+
+  OfxPipelineEvent &front();
+  void pop()
+  {
+    _head.store(_head.load(memory_order_relaxed) + 1, memory_order_release);
+  };
+
+private:
+  /** The events of an account are generated at once: the parse can only
+      go on with the next statement once they fit */
+  enum { CAPACITY = 1024 };
+
+  OfxPipelineEvent _slots[CAPACITY];
+  atomic<unsigned long> _head; /**< Next slot to read, only moved by the consumer */
+  atomic<unsigned long> _tail; /**< Next slot to write, only moved by the producer */
+};
+
+/**
+ * \brief An OFX or OFC file parsed on a thread of its own, whose events
+ * are taken one by one by the thread that created it.
+ *
+ * The parsing thread has its own context, whose callbacks queue the
+ * events.  Until the first security or investment account, the events of
+ * each account are generated as soon as its statement ends; the others
+ * come at the end of the file, as from libofx_proc_file().
+ */
+class OfxPipeline
+{
+public:
+  /** Starts parsing, with the DTD directory and the log callback of libofx_context */
+  OfxPipeline(LibofxContext *libofx_context, const char *p_filename, LibofxFileFormat file_type);
+  /** Aborts the parse if it isn't done, and waits for the parsing thread */
+  ~OfxPipeline();
+
+  /** The next event, waiting for it; NULL at the end of the file.  The
+      event and the data it points to are valid until the next call. */
+  OfxPipelineEvent *next();
+  /** Stop the parse as soon as possible: next() returns NULL from now on */
+  void abort();
+
+  /**
+   * \brief The statistics of the parse, once next() returned NULL
+   *
+   The time spent queueing the events is part of container_ns.  The
+   events are used on another thread, which spent callback_ns in the
+   callbacks: it counts as part of container_ns and sgml_parsing_ns too,
+   as in a parse on one thread.
+  */
+  struct LibofxStats stats(unsigned long long callback_ns)
+  {
+    struct LibofxStats parse_stats = context.stats();
+    parse_stats.sgml_parsing_ns += callback_ns;
+    parse_stats.container_ns += callback_ns;
+    parse_stats.callback_ns = callback_ns;
+    return parse_stats;
+  };
+
+private:
+  static void run(OfxPipeline *pipeline, string filename);
+  static OfxPipelineEvent *next_event(void *pipeline, OfxPipelineEvent::Type type);
+  static int queue_event(void *pipeline);
+  static int queue_status(const struct OfxStatusData data, void *pipeline);
+  static int queue_security(const struct OfxSecurityData data, void *pipeline);
+  static int queue_account(const struct OfxAccountData data, void *pipeline);
+  static int queue_statement(const struct OfxStatementData data, void *pipeline);
+  static int queue_transaction(const struct OfxTransactionData data, void *pipeline);
+
+  LibofxContext context; /**< Of the parsing thread */
+  vector<OfxMainContainer *> main_containers; /**< Kept until the events pointing to their data are used */
+  OfxEventQueue queue;
+  atomic<bool> aborted;
+  bool returned; /**< The front event was returned by next(), and is popped by the next call */
+  bool ended; /**< The end of the file was reached */
+  thread parser;
+};
+
+/**
+ * \brief Processes an OFX file on a parsing thread, calling the callbacks
+ * of the context from the calling thread
+ */
+void ofx_proc_file_pipelined(LibofxContext *libofx_context, const char *p_filename);
+
+#endif
@@ -23,6 +23,7 @@
 #include <cstdlib>
 #include <stdio.h>
 #include <string>
+#include <mutex>
 #include "ParserEventGeneratorKit.h"
 #include "libofx.h"
 #include "messages.hh"
@@ -30,6 +31,7 @@
 #include "ofc_sgml.hh"
 #include "ofx_preproc.hh"
 #include "ofx_utilities.hh"
+#include "probes.hh"
 #ifdef HAVE_ICONV
 #include <iconv.h>
 #endif
@@ -74,6 +76,34 @@ const char *DTD_SEARCH_PATH[DTD_SEARCH_PATH_NUM] =
 };
 const unsigned int READ_BUFFER_SIZE = 1024;
 
+/** The putenv() calls of ofx_set_opensp_environment() */
+static void put_opensp_environment()
+{
+  static char sp_charset_fixed[] = "SP_CHARSET_FIXED=1";
+  if (putenv(sp_charset_fixed) != 0)
+  {
+    message_out(ERROR, "ofx_set_opensp_environment(): putenv failed");
+  }
+  /* Normally SP_ENCODING would be "xml" for the XML files.
+   * Unfortunately, opensp's generic api will garble UTF-8 if this is
+   * set to xml.  So we set any single byte encoding to avoid messing
+   * up UTF-8.  Unfortunately this means that non-UTF-8 files will not
+   * get properly translated.  We'd need to manually detect the
+   * encoding in the XML header and convert the xml with iconv like we
+   * do for SGML to work around the problem.  Most unfortunate. */
+  static char sp_encoding[] = "SP_ENCODING=ms-dos";
+  if (putenv(sp_encoding) != 0)
+  {
+    message_out(ERROR, "ofx_set_opensp_environment(): putenv failed");
+  }
+}
+
+void ofx_set_opensp_environment()
+{
+  static std::once_flag once;
+  std::call_once(once, put_opensp_environment);
+}
+
 /** @brief File pre-processing of OFX AND for OFC files
 *
 * Takes care of comment striping, dtd locating, etc.
@@ -128,6 +158,8 @@ int ofx_proc_file(LibofxContextPtr ctx, const char * p_filename)
 
     if (input_file && tmp_file)
     {
+      OfxStatsTimer header_timer(libofx_context->stats().header_parsing_ns);
+      OFX_PROBE1(phase__start, "headers");
       int header_separator_idx;
       string header_name;
       string header_value;
@@ -171,6 +203,7 @@ int ofx_proc_file(LibofxContextPtr ctx, const char * p_filename)
         // Continue reading as long as we're not at EOF *and* we've not yet
         // reached an end-of-line.
         while (!input_file.eof() && !end_of_line);
+        libofx_context->stats().bytes_read += s_buffer.size();
 
         if (ofx_start == false && (s_buffer.find("<?xml") != string::npos))
         {
@@ -197,38 +230,9 @@ int ofx_proc_file(LibofxContextPtr ctx, const char * p_filename)
           }
           message_out(DEBUG, "ofx_proc_file():<OFX> or <OFC> has been found");
 
-          if (file_is_xml == true)
-          {
-            static char sp_charset_fixed[] = "SP_CHARSET_FIXED=1";
-            if (putenv(sp_charset_fixed) != 0)
-            {
-              message_out(ERROR, "ofx_proc_file(): putenv failed");
-            }
-            /* Normally the following would be "xml".
-             * Unfortunately, opensp's generic api will garble UTF-8 if this is
-             * set to xml.  So we set any single byte encoding to avoid messing
-             * up UTF-8.  Unfortunately this means that non-UTF-8 files will not
-             * get properly translated.  We'd need to manually detect the
-             * encoding in the XML header and convert the xml with iconv like we
-             * do for SGML to work around the problem.  Most unfortunate. */
-            static char sp_encoding[] = "SP_ENCODING=ms-dos";
-            if (putenv(sp_encoding) != 0)
-            {
-              message_out(ERROR, "ofx_proc_file(): putenv failed");
-            }
-          }
-          else
+          ofx_set_opensp_environment();
+          if (file_is_xml == false)
           {
-            static char sp_charset_fixed[] = "SP_CHARSET_FIXED=1";
-            if (putenv(sp_charset_fixed) != 0)
-            {
-              message_out(ERROR, "ofx_proc_file(): putenv failed");
-            }
-            static char sp_encoding[] = "SP_ENCODING=ms-dos"; //Any single byte encoding will do, we don't want opensp messing up UTF-8;
-            if (putenv(sp_encoding) != 0)
-            {
-              message_out(ERROR, "ofx_proc_file(): putenv failed");
-            }
 #ifdef HAVE_ICONV
             string fromcode;
             string tocode;
@@ -299,12 +303,17 @@ int ofx_proc_file(LibofxContextPtr ctx, const char * p_filename)
              * as the xml header, but as opensp can't be used to parse it anyway
              * this isn't a great loss for now.
              */
+            OfxStatsTimer timer(libofx_context->stats().sanitize_ns);
+            OFX_PROBE1(phase__start, "sanitize");
             s_buffer = sanitize_proprietary_tags(s_buffer);
+            OFX_PROBE1(phase__end, "sanitize");
           }
           //cout<< s_buffer<<"\n";
           if (file_is_xml == false)
           {
 #ifdef HAVE_ICONV
+            OfxStatsTimer timer(libofx_context->stats().iconv_ns);
+            OFX_PROBE1(phase__start, "iconv");
             size_t inbytesleft = s_buffer.size();
             size_t outbytesleft = inbytesleft * 2 - 1;
             char * iconv_buffer = (char*) malloc (inbytesleft * 2);
@@ -326,6 +335,7 @@ int ofx_proc_file(LibofxContextPtr ctx, const char * p_filename)
             // original buffer
             s_buffer = std::string(iconv_buffer, outchar - iconv_buffer);
             free (iconv_buffer);
+            OFX_PROBE1(phase__end, "iconv");
 #endif
           }
           //cout << s_buffer << "\n";
@@ -349,6 +359,7 @@ int ofx_proc_file(LibofxContextPtr ctx, const char * p_filename)
 
       }
       while (!input_file.eof() && !input_file.bad());
+      OFX_PROBE1(phase__end, "headers");
     }
     input_file.close();
     tmp_file.close();
@@ -361,6 +372,8 @@ int ofx_proc_file(LibofxContextPtr ctx, const char * p_filename)
     char filename_openspdtd[255];
     char filename_dtd[255];
     char filename_ofx[255];
+    unsigned long long dtd_start = stats_now_ns();
+    OFX_PROBE1(phase__start, "dtd");
     strncpy(filename_openspdtd, find_dtd(ctx, OPENSPDCL_FILENAME).c_str(), 255); //The opensp sgml dtd file
     if (libofx_context->currentFileType() == OFX)
     {
@@ -374,6 +387,8 @@ int ofx_proc_file(LibofxContextPtr ctx, const char * p_filename)
     {
       message_out(ERROR, string("ofx_proc_file(): Error unknown file format for the OFX parser"));
     }
+    libofx_context->stats().dtd_ns += stats_now_ns() - dtd_start;
+    OFX_PROBE1(phase__end, "dtd");
 
     if ((string)filename_dtd != "" && (string)filename_openspdtd != "")
     {
@@ -381,6 +396,7 @@ int ofx_proc_file(LibofxContextPtr ctx, const char * p_filename)
       filenames[0] = filename_openspdtd;
       filenames[1] = filename_dtd;
       filenames[2] = filename_ofx;
+      OFX_PROBE1(phase__start, "sgml");
       if (libofx_context->currentFileType() == OFX)
       {
         ofx_proc_sgml(libofx_context, 3, filenames);
@@ -393,6 +409,7 @@ int ofx_proc_file(LibofxContextPtr ctx, const char * p_filename)
       {
         message_out(ERROR, string("ofx_proc_file(): Error unknown file format for the OFX parser"));
       }
+      OFX_PROBE1(phase__end, "sgml");
       if (remove(tmp_filename) != 0)
       {
         message_out(ERROR, "ofx_proc_file(): Error deleting temporary file " + string(tmp_filename));
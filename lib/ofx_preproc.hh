@@ -37,5 +37,13 @@ std::string find_dtd(LibofxContextPtr ctx, const std::string& dtd_filename);
  files to be parsed in command line format.
 */
 int ofx_proc_file(LibofxContextPtr libofx_context, const char *);
+/**
+ * \brief Sets the environment variables OpenSP is to be run with, once
+ * per process.
+ *
+ * putenv() isn't safe while other threads read the environment: called
+ * before starting the threads that parse files.
+ */
+void ofx_set_opensp_environment();
 
 #endif
@@ -0,0 +1,238 @@
+/***************************************************************************
+                          ofx_probe.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Reading the headers and the start of an OFX file, without parsing it
+ *
+ * libofx_probe_file() and libofx_probe_buffer() give an application what
+ * it needs to route a file or to spot a duplicate, for a small part of
+ * the cost of libofx_proc_file(): the file isn't copied, converted or
+ * validated against the DTD, and the reading stops at the first
+ * transaction.
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "libofx.h"
+#include "messages.hh"
+#include "context.hh"
+#include "ofx_utilities.hh"
+#include "ofx_tag_scanner.hh"
+
+using namespace std;
+
+static const size_t PROBE_READ_SIZE = 4096;
+
+static void copy_field(char *dest, size_t size, const string &value)
+{
+  strncpy(dest, value.c_str(), size - 1);
+  dest[size - 1] = '\0';
+}
+
+/**
+ * \brief Fills an OfxProbeData from the tags of a file
+ */
+class OfxProber: public OfxTagScanner
+{
+public:
+  OfxProber(struct OfxProbeData &p_data, OfxTimezoneCache *p_timezone_cache);
+protected:
+  virtual void header_line(const string &line);
+  virtual void start_tag(const string &name, unsigned long long offset);
+  virtual void end_tag(const string &name, unsigned long long end_offset);
+  virtual void value(const string &name, string &text);
+private:
+  void processing_instruction(const string &pi);
+
+  struct OfxProbeData &data;
+  OfxTimezoneCache *timezone_cache;
+  bool in_sonrs;
+  bool in_sonrs_status;
+  bool in_account;
+  OfxScannedAccount account;
+  bool in_tranlist;
+};
+
+OfxProber::OfxProber(struct OfxProbeData &p_data, OfxTimezoneCache *p_timezone_cache)
+  : data(p_data)
+  , timezone_cache(p_timezone_cache)
+{
+  memset(&data, 0, sizeof(data));
+  in_sonrs = false;
+  in_sonrs_status = false;
+  in_account = false;
+  in_tranlist = false;
+}
+
+void OfxProber::header_line(const string &line)
+{
+  size_t pi_start = line.find("<?");
+  if (pi_start != string::npos)
+  {
+    while (pi_start != string::npos)
+    {
+      size_t pi_end = line.find("?>", pi_start);
+      processing_instruction(line.substr(pi_start + 2, pi_end == string::npos ? string::npos : pi_end - pi_start - 2));
+      pi_start = pi_end == string::npos ? string::npos : line.find("<?", pi_end);
+    }
+    return;
+  }
+
+  size_t separator = line.find(':');
+  if (separator == string::npos)
+    return;
+  string name = line.substr(0, separator);
+  string header_value = line.substr(separator + 1);
+  strip_whitespace(name);
+  strip_whitespace(header_value);
+  if (name == "VERSION")
+    copy_field(data.version, sizeof(data.version), header_value);
+  else if (name == "ENCODING")
+    copy_field(data.encoding, sizeof(data.encoding), header_value);
+  else if (name == "CHARSET")
+    copy_field(data.charset, sizeof(data.charset), header_value);
+  else if (name == "OLDFILEUID")
+    copy_field(data.old_file_uid, sizeof(data.old_file_uid), header_value);
+  else if (name == "NEWFILEUID")
+    copy_field(data.new_file_uid, sizeof(data.new_file_uid), header_value);
+}
+
+/** The attributes of <?xml?> and <?OFX?>, which hold the headers of the XML files */
+void OfxProber::processing_instruction(const string &pi)
+{
+  bool is_xml = pi.compare(0, 3, "xml") == 0;
+  bool is_ofx = pi.compare(0, 3, "OFX") == 0;
+  size_t equal = pi.find('=');
+  while (equal != string::npos)
+  {
+    size_t name_start = pi.find_last_of(" \t\r\n", equal);
+    string name = pi.substr(name_start == string::npos ? 0 : name_start + 1,
+                            name_start == string::npos ? equal : equal - name_start - 1);
+    size_t quote = pi.find_first_of("\"'", equal);
+    if (quote == string::npos)
+      break;
+    size_t end = pi.find(pi[quote], quote + 1);
+    string attribute = pi.substr(quote + 1, end == string::npos ? string::npos : end - quote - 1);
+    if (is_xml && name == "encoding")
+      copy_field(data.encoding, sizeof(data.encoding), attribute);
+    else if (is_ofx && name == "VERSION")
+      copy_field(data.version, sizeof(data.version), attribute);
+    else if (is_ofx && name == "OLDFILEUID")
+      copy_field(data.old_file_uid, sizeof(data.old_file_uid), attribute);
+    else if (is_ofx && name == "NEWFILEUID")
+      copy_field(data.new_file_uid, sizeof(data.new_file_uid), attribute);
+    equal = end == string::npos ? string::npos : pi.find('=', end);
+  }
+}
+
+void OfxProber::start_tag(const string &name, unsigned long long offset)
+{
+  if (in_tranlist && name != "DTSTART" && name != "DTEND")
+  {
+    /* The first transaction: everything we want comes before it */
+    stop();
+  }
+  else if (name == "SONRS")
+    in_sonrs = true;
+  else if (name == "STATUS" && in_sonrs)
+    in_sonrs_status = true;
+  else if (!data.account_id_valid && !in_account && account.start(name))
+    in_account = true;
+  else if (name == "BANKTRANLIST" || name == "INVTRANLIST")
+    in_tranlist = true;
+}
+
+void OfxProber::end_tag(const string &name, unsigned long long end_offset)
+{
+  if (name == "SONRS")
+    in_sonrs = in_sonrs_status = false;
+  else if (name == "STATUS")
+    in_sonrs_status = false;
+  else if (in_account && account.end(name))
+  {
+    copy_field(data.account_id, sizeof(data.account_id), account.account_id());
+    data.account_id_valid = true;
+    in_account = false;
+  }
+  else if (name == "BANKTRANLIST" || name == "INVTRANLIST" || name == "OFX")
+    stop();
+}
+
+/** Data of an element, in the SGML files where it has no end tag as in the XML ones */
+void OfxProber::value(const string &name, string &text)
+{
+  if (in_sonrs_status && name == "CODE")
+  {
+    data.status_code = atoi(text.c_str());
+    data.status_code_valid = true;
+  }
+  else if (in_sonrs_status && name == "SEVERITY")
+    copy_field(data.status_severity, sizeof(data.status_severity), text);
+  else if (in_account)
+    account.value(name, text);
+  else if (in_tranlist && name == "DTSTART")
+  {
+    data.date_start = ofxdate_to_time_t(text, timezone_cache);
+    data.date_start_valid = true;
+  }
+  else if (in_tranlist && name == "DTEND")
+  {
+    data.date_end = ofxdate_to_time_t(text, timezone_cache);
+    data.date_end_valid = true;
+  }
+}
+
+int libofx_probe_file(LibofxContextPtr ctx, const char *p_filename, struct OfxProbeData *data)
+{
+  LibofxContext *libofx_context = (LibofxContext *)ctx;
+  OfxLogScope log_scope(libofx_context);
+  OfxProber prober(*data, libofx_context->timezoneCache());
+
+  FILE *input_file = p_filename != NULL ? fopen(p_filename, "rb") : NULL;
+  if (input_file == NULL)
+  {
+    message_out(ERROR, "libofx_probe_file(): Unable to open the input file " + string(p_filename != NULL ? p_filename : ""));
+    return -1;
+  }
+  char buffer[PROBE_READ_SIZE];
+  size_t read_size;
+  while ((read_size = fread(buffer, 1, sizeof(buffer), input_file)) > 0)
+  {
+    libofx_context->stats().bytes_read += read_size;
+    if (!prober.feed(buffer, read_size))
+      break;
+  }
+  fclose(input_file);
+
+  if (!prober.found_ofx())
+  {
+    message_out(ERROR, "libofx_probe_file(): No <OFX> element in " + string(p_filename));
+    return -1;
+  }
+  return 0;
+}
+
+int libofx_probe_buffer(LibofxContextPtr ctx, const char *s, unsigned int size, struct OfxProbeData *data)
+{
+  LibofxContext *libofx_context = (LibofxContext *)ctx;
+  OfxLogScope log_scope(libofx_context);
+  OfxProber prober(*data, libofx_context->timezoneCache());
+
+  prober.feed(s, size);
+  if (!prober.found_ofx())
+  {
+    message_out(ERROR, "libofx_probe_buffer(): No <OFX> element in the buffer");
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,133 @@
+/***************************************************************************
+                          ofx_reader.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Implementation of ofx::Reader
+ *
+ * The Reader takes the events of an OfxPipeline, as
+ * ofx_proc_file_pipelined() does, and returns them to the application
+ * instead of calling the callbacks.  The events point to the slots of the
+ * pipeline's queue, which are only reused once the next event is asked.
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <string>
+#include "libofx.h"
+#include "libofx_reader.hh"
+#include "messages.hh"
+#include "context.hh"
+#include "file_preproc.hh"
+#include "ofx_pipeline.hh"
+
+namespace ofx
+{
+
+struct Reader::Impl
+{
+  LibofxContext *context;
+  LibofxContext *own_context; /**< When the application gave none */
+  OfxPipeline *pipeline; /**< NULL if the file has no events */
+  bool skipping; /**< skip_statement() was called */
+  OfxPipelineEvent::Type previous;
+};
+
+Reader::Reader(LibofxContextPtr libofx_context, const char *p_filename, enum LibofxFileFormat file_type)
+{
+  impl = new Impl();
+  impl->own_context = libofx_context == NULL ? new LibofxContext() : NULL;
+  impl->context = libofx_context == NULL ? impl->own_context : (LibofxContext *)libofx_context;
+  impl->pipeline = NULL;
+  impl->skipping = false;
+  impl->previous = OfxPipelineEvent::END;
+
+  OfxLogScope log_scope(impl->context);
+  if (file_type == AUTODETECT)
+    file_type = libofx_detect_file_type(p_filename);
+  if (file_type == OFX || file_type == OFC)
+    impl->pipeline = new OfxPipeline(impl->context, p_filename, file_type);
+  else
+    message_out(ERROR, string("ofx::Reader: Detected file format not supported or couldn't detect file format of ") + (p_filename != NULL ? p_filename : ""));
+}
+
+Reader::~Reader()
+{
+  if (impl->pipeline != NULL)
+  {
+    OfxLogScope log_scope(impl->context);
+    impl->pipeline->abort();
+    add_stats(impl->context->stats(), impl->pipeline->stats(0));
+    delete impl->pipeline;
+  }
+  delete impl->own_context;
+  delete impl;
+}
+
+Event Reader::next()
+{
+  Event event;
+  OfxPipelineEvent *queued;
+  while (impl->pipeline != NULL && (queued = impl->pipeline->next()) != NULL)
+  {
+    /* As OfxMainContainer::gen_event(): a skip lasts until the next
+       account, or the end of the securities, and the parse ignores the
+       ones from a status */
+    if (queued->type == OfxPipelineEvent::ACCOUNT
+        || (queued->type == OfxPipelineEvent::SECURITY && impl->previous != OfxPipelineEvent::SECURITY)
+        || impl->previous == OfxPipelineEvent::STATUS)
+      impl->skipping = false;
+    impl->previous = queued->type;
+
+    switch (queued->type)
+    {
+    case OfxPipelineEvent::STATUS:
+      event.type = Event::STATUS;
+      event.status = &queued->status;
+      return event;
+    case OfxPipelineEvent::ACCOUNT:
+      event.type = Event::ACCOUNT;
+      event.account = &queued->account;
+      return event;
+    case OfxPipelineEvent::SECURITY:
+      if (impl->skipping)
+        break;
+      event.type = Event::SECURITY;
+      event.security = &queued->security;
+      return event;
+    case OfxPipelineEvent::STATEMENT:
+      if (impl->skipping)
+        break;
+      event.type = Event::STATEMENT;
+      event.statement = &queued->statement;
+      return event;
+    case OfxPipelineEvent::TRANSACTION:
+      if (impl->skipping)
+        break;
+      event.type = Event::TRANSACTION;
+      event.transaction = &queued->transaction;
+      return event;
+    default:
+      break;
+    }
+  }
+  return event;
+}
+
+void Reader::skip_statement()
+{
+  impl->skipping = true;
+}
+
+void Reader::abort()
+{
+  if (impl->pipeline != NULL)
+    impl->pipeline->abort();
+}
+
+}
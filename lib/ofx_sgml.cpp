@@ -31,13 +31,54 @@
 #include "ofx_utilities.hh"
 #include "messages.hh"
 #include "ofx_containers.hh"
+#include "probes.hh"
 #include "ofx_sgml.hh"
 
 using namespace std;
 
-OfxMainContainer * MainContainer = NULL;
-extern SGMLApplication::OpenEntityPtr entity_ptr;
-extern SGMLApplication::Position position;
+thread_local OfxMainContainer * MainContainer = NULL;
+extern thread_local SGMLApplication::OpenEntityPtr entity_ptr;
+extern thread_local SGMLApplication::Position position;
+
+/**
+   \brief Aggregates whose whole subtree holds nothing LibOFX consumes.
+
+   These are skipped by OFXApplication without creating an OfxDummyContainer
+   for them or for any of their children, and without converting their data.
+   Only aggregates that can never contain a supported element may be listed
+   here (SIGNONMSGSRSV1 or BANKMSGSRSV1 for example can't, they wrap STATUS
+   and the statements).
+*/
+static const char *SKIPPED_AGGREGATES[] =
+{
+  "INVPOSLIST",     /* Positions */
+  "INVOOLIST",      /* Open orders */
+  "INVBAL",         /* Investment balances, including BALLIST */
+  "BALLIST",
+  "INV401K",
+  "INV401KBAL",
+  "MFASSETCLASS",   /* Inside MFINFO */
+  "FIMFASSETCLASS",
+  "FI",             /* Inside SONRS */
+  "PAYEE",          /* Inside STMTTRN */
+  "BANKACCTTO",
+  "CCACCTTO",
+  "CURRENCY",
+  "ORIGCURRENCY",
+  NULL
+};
+
+static bool is_skipped_aggregate(const string & identifier)
+{
+  for (int i = 0; SKIPPED_AGGREGATES[i] != NULL; i++)
+  {
+    if (identifier == SKIPPED_AGGREGATES[i])
+    {
+      return true;
+    }
+  }
+  return false;
+}
 
 
 /** \brief This object is driven by OpenSP as it parses the SGML from the ofx file(s)
@@ -49,20 +90,52 @@ private:
   OfxGenericContainer *tmp_container_element;
   bool is_data_element; /**< If the SGML element contains data, this flag is raised */
   string incoming_data; /**< The raw data from the SGML data element */
+  unsigned int skipped_depth; /**< Element nesting depth inside a skipped aggregate, 0 when not skipping */
   LibofxContext * libofx_context;
+  EventGenerator * event_generator;
 
 public:
 
-  OFXApplication (LibofxContext * p_libofx_context)
+  OFXApplication (LibofxContext * p_libofx_context, EventGenerator * p_event_generator)
   {
     MainContainer = NULL;
     curr_container_element = NULL;
     is_data_element = false;
+    skipped_depth = 0;
     libofx_context = p_libofx_context;
+    event_generator = p_event_generator;
   }
   ~OFXApplication()
   {
     message_out(DEBUG, "Entering the OFXApplication's destructor");
+    if (libofx_context->aborted())
+    {
+      /* A callback stopped the parsing: free the containers still open */
+      while (curr_container_element != NULL)
+      {
+        OfxGenericContainer *parent = curr_container_element->getparent();
+        if (curr_container_element == MainContainer)
+        {
+          MainContainer = NULL;
+        }
+        delete curr_container_element;
+        curr_container_element = parent;
+      }
+      delete MainContainer;
+      MainContainer = NULL;
+    }
+  }
+
+  /** \brief A callback returned LIBOFX_ABORT: halts OpenSP, which may still send a few events until it stops.
+   */
+  bool stopped()
+  {
+    if (!libofx_context->aborted())
+    {
+      return false;
+    }
+    event_generator->halt();
+    return true;
   }
 
   /** \brief Callback: Start of an OFX element
@@ -71,8 +144,22 @@ public:
   */
   void startElement (const StartElementEvent & event)
   {
+    OfxStatsTimer timer(libofx_context->stats().container_ns);
+    if (stopped())
+    {
+      return;
+    }
+    libofx_context->stats().elements++;
+    if (skipped_depth > 0)
+    {
+      /* Inside a skipped aggregate, only keep track of the nesting */
+      skipped_depth++;
+      return;
+    }
+
     string identifier;
     CharStringtostring (event.gi, identifier);
+    OFX_PROBE1(element__start, identifier.c_str());
     message_out(PARSER, "startElement event received from OpenSP for element " + identifier);
 
     position = event.pos;
@@ -191,6 +278,12 @@ public:
         message_out (PARSER, "Element " + identifier + " found");
         curr_container_element = new OfxBalanceContainer (libofx_context, curr_container_element, identifier);
       }
+      else if (is_skipped_aggregate(identifier))
+      {
+        /* Nothing in there is of use to us, ignore everything up to the matching end tag */
+        message_out (INFO, "Skipping unsupported aggregate " + identifier);
+        skipped_depth = 1;
+      }
       else
       {
         /* We dont know this OFX element, so we create a dummy container */
@@ -201,6 +294,7 @@ public:
     {
       /* The element was a data element.  OpenSP will call one or several data() callback with the data */
       message_out (PARSER, "Data element " + identifier + " found");
+      libofx_context->stats().data_elements++;
       /* There is a bug in OpenSP 1.3.4, which won't send endElement Event for some elements, and will instead send an error like "document type does not allow element "MESSAGE" here".  Incoming_data should be empty in such a case, but it will not be if the endElement event was skiped. So we empty it, so at least the last element has a chance of having valid data */
       if (incoming_data != "")
       {
@@ -216,11 +310,23 @@ public:
   */
   void endElement (const EndElementEvent & event)
   {
+    OfxStatsTimer timer(libofx_context->stats().container_ns);
+    if (stopped())
+    {
+      return;
+    }
+    if (skipped_depth > 0)
+    {
+      skipped_depth--;
+      return;
+    }
+
     string identifier;
     bool end_element_for_data_element;
 
     CharStringtostring (event.gi, identifier);
     end_element_for_data_element = is_data_element;
+    OFX_PROBE1(element__end, identifier.c_str());
     message_out(PARSER, "endElement event received from OpenSP for element " + identifier);
 
     position = event.pos;
@@ -233,7 +339,7 @@ public:
     {
       if (end_element_for_data_element == true)
       {
-        incoming_data = strip_whitespace(incoming_data);
+        strip_whitespace(incoming_data);
 
         curr_container_element->add_attribute (identifier, incoming_data);
         message_out (PARSER, "endElement: Added data '" + incoming_data + "' from " + identifier + " to " + curr_container_element->type + " container_element");
@@ -259,7 +365,15 @@ public:
               //Defensive coding, this isn't supposed to happen
               curr_container_element = tmp_container_element;
             }
-            if (MainContainer != NULL)
+            if (MainContainer != NULL && libofx_context->keptMainContainers() != NULL)
+            {
+              /* A worker of a parallel parse or a pipeline: the events are generated later */
+              libofx_context->keptMainContainers()->push_back(MainContainer);
+              MainContainer = NULL;
+              curr_container_element = NULL;
+              message_out (DEBUG, "Element " + identifier + " closed, MainContainer kept");
+            }
+            else if (MainContainer != NULL)
             {
               MainContainer->gen_event();
               delete MainContainer;
@@ -301,7 +415,16 @@ public:
   */
   void data (const DataEvent & event)
   {
-    string tmp;
+    OfxStatsTimer timer(libofx_context->stats().container_ns);
+    if (stopped())
+    {
+      return;
+    }
+    if (skipped_depth > 0)
+    {
+      return;
+    }
+
     position = event.pos;
     AppendCharStringtostring (event.data, incoming_data);
     message_out(PARSER, "data event received from OpenSP, incoming_data is now: " + incoming_data);
@@ -377,12 +500,20 @@ int ofx_proc_sgml(LibofxContext * libofx_context, int argc, char * const* argv)
   message_out(DEBUG, argv[1]);
   message_out(DEBUG, argv[2]);
 
+  libofx_context->timezoneCache()->clear_memo();
+
+  unsigned long long sgml_start = stats_now_ns();
   ParserEventGeneratorKit parserKit;
   parserKit.setOption (ParserEventGeneratorKit::showOpenEntities);
   EventGenerator *egp =	parserKit.makeEventGenerator (argc, argv);
   egp->inhibitMessages (true);	/* Error output is handled by libofx not OpenSP */
-  OFXApplication *app = new OFXApplication(libofx_context);
+  OFXApplication *app = new OFXApplication(libofx_context, egp);
   unsigned nErrors = egp->run (*app); /* Begin parsing */
   delete egp;  //Note that this is where bug is triggered
+  delete app;
+  libofx_context->stats().sgml_parsing_ns += stats_now_ns() - sgml_start;
+
+  libofx_context->stats().date_cache_hits += libofx_context->timezoneCache()->memo_hits;
+  libofx_context->stats().date_cache_misses += libofx_context->timezoneCache()->memo_misses;
   return nErrors > 0;
 }
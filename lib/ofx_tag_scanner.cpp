@@ -0,0 +1,150 @@
+/***************************************************************************
+                          ofx_tag_scanner.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Implementation of OfxTagScanner and OfxScannedAccount
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <cctype>
+#include <string>
+#include "libofx.h"
+#include "messages.hh"
+#include "ofx_utilities.hh"
+#include "ofx_tag_scanner.hh"
+
+/** Longer header lines, tags or values are not ours, and are cut */
+static const size_t SCANNER_MAX_TOKEN = 1024;
+
+OfxTagScanner::OfxTagScanner()
+{
+  done = false;
+  in_body = false;
+  position = 0;
+  ofx_start = 0;
+  tag_start = 0;
+  in_tag = false;
+}
+
+bool OfxTagScanner::feed(const char *s, size_t size)
+{
+  size_t i = 0;
+  while (i < size && !in_body && !done)
+  {
+    char c = s[i++];
+    header += c;
+    if (c == '\n' || header.size() > SCANNER_MAX_TOKEN)
+    {
+      header_line(header);
+      header.clear();
+      continue;
+    }
+    size_t ofx_idx = header.size() >= 5 ? header.size() - 5 : string::npos;
+    if (ofx_idx != string::npos &&
+        (header.compare(ofx_idx, 5, "<OFX>") == 0 || header.compare(ofx_idx, 5, "<ofx>") == 0))
+    {
+      /* Fix for really broken files that don't have a newline after the header */
+      header_line(header.substr(0, ofx_idx));
+      header.clear();
+      in_body = true;
+      ofx_start = position + i - 5;
+      message_out(DEBUG, "OfxTagScanner: <OFX> has been found");
+      start_tag("OFX", ofx_start);
+    }
+  }
+
+  for (; i < size && !done; i++)
+  {
+    char c = s[i];
+    if (c == '<')
+    {
+      if (!in_tag && !open_element.empty())
+      {
+        strip_whitespace(token);
+        if (!token.empty())
+          value(open_element, token);
+      }
+      open_element.clear();
+      token.clear();
+      in_tag = true;
+      tag_start = position + i;
+    }
+    else if (c == '>' && in_tag)
+    {
+      in_tag = false;
+      if (!token.empty() && token[0] != '!' && token[0] != '?')
+      {
+        if (token[0] == '/')
+          end_tag(token.substr(1), position + i + 1);
+        else
+        {
+          start_tag(token, tag_start);
+          open_element = token;
+        }
+      }
+      token.clear();
+    }
+    else if (token.size() < SCANNER_MAX_TOKEN)
+    {
+      token += in_tag ? toupper((unsigned char)c) : c;
+    }
+  }
+  position += i;
+  return !done;
+}
+
+bool OfxScannedAccount::start(const string &name)
+{
+  if (name != "BANKACCTFROM" && name != "CCACCTFROM" && name != "INVACCTFROM")
+    return false;
+  aggregate = name;
+  type = name;
+  bankid.clear();
+  branchid.clear();
+  acctid.clear();
+  acctkey.clear();
+  brokerid.clear();
+  return true;
+}
+
+bool OfxScannedAccount::end(const string &name)
+{
+  if (aggregate.empty() || name != aggregate)
+    return false;
+  aggregate.clear();
+  return true;
+}
+
+void OfxScannedAccount::value(const string &name, const string &text)
+{
+  if (aggregate.empty())
+    return;
+  if (name == "BANKID")
+    bankid = text;
+  else if (name == "BRANCHID")
+    branchid = text;
+  else if (name == "ACCTID")
+    acctid = text;
+  else if (name == "ACCTKEY")
+    acctkey = text;
+  else if (name == "BROKERID")
+    brokerid = text;
+}
+
+string OfxScannedAccount::account_id() const
+{
+  /* Same format as OfxAccountContainer::gen_account_id() */
+  if (type == "CCACCTFROM")
+    return acctid + " " + acctkey;
+  else if (type == "INVACCTFROM")
+    return brokerid + " " + acctid;
+  else
+    return bankid + " " + branchid + " " + acctid;
+}
@@ -0,0 +1,100 @@
+/***************************************************************************
+                          ofx_tag_scanner.hh
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Lightweight scanning of the tags of an OFX file
+ *
+ * The probe and the statement index only need to know where some
+ * elements start and end, and the values of a few of them.  The
+ * OfxTagScanner finds the tags directly in the bytes of the file, without
+ * the DTD: this works the same for the SGML and the XML files, but
+ * doesn't validate anything.
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef OFX_TAG_SCANNER_H
+#define OFX_TAG_SCANNER_H
+
+#include <string>
+
+using namespace std;
+
+/**
+ * \brief Scans the bytes of an OFX file handed in pieces
+ *
+ The lines before the <OFX> tag go to header_line(), then each tag and
+ element value to the other virtual methods.  The tag names are upper
+ cased; comments and processing instructions are skipped.
+ */
+class OfxTagScanner
+{
+public:
+  OfxTagScanner();
+  virtual ~OfxTagScanner() {};
+  /** Scans the next bytes of the file
+      @return false once stop() was called */
+  bool feed(const char *s, size_t size);
+  /** Whether the <OFX> element was found */
+  bool found_ofx() const
+  {
+    return in_body;
+  };
+  /** Offset of the < of the <OFX> tag */
+  unsigned long long ofx_offset() const
+  {
+    return ofx_start;
+  };
+protected:
+  /** A line of the headers, with its end of line */
+  virtual void header_line(const string &line) {};
+  /** @param offset offset of the < of the tag */
+  virtual void start_tag(const string &name, unsigned long long offset) {};
+  /** @param name the name of the element, without the /
+      @param end_offset offset of the byte after the > of the tag */
+  virtual void end_tag(const string &name, unsigned long long end_offset) {};
+  /** The data following a start tag, whitespace stripped and not empty */
+  virtual void value(const string &name, string &text) {};
+  /** Don't scan any further */
+  void stop()
+  {
+    done = true;
+  };
+private:
+  bool done;
+  bool in_body; /**< Past the headers */
+  unsigned long long position; /**< Offset of the next byte fed */
+  unsigned long long ofx_start;
+  unsigned long long tag_start; /**< Offset of the < of the current tag */
+  string header; /**< Current line of the headers */
+  bool in_tag;
+  string token; /**< Tag name, or text since the last tag */
+  string open_element; /**< Last start tag, if text may follow it */
+};
+
+/**
+ * \brief Collects the account of a BANKACCTFROM, CCACCTFROM or INVACCTFROM
+ */
+class OfxScannedAccount
+{
+public:
+  /** Whether the element starts an account aggregate, which it then collects */
+  bool start(const string &name);
+  /** Whether the element ends the account aggregate being collected */
+  bool end(const string &name);
+  void value(const string &name, const string &text);
+  /** The account id, in the format of OfxAccountData.account_id */
+  string account_id() const;
+private:
+  string aggregate; /**< The aggregate being collected, if any */
+  string type; /**< The last aggregate collected */
+  string bankid, branchid, acctid, acctkey, brokerid;
+};
+
+#endif
@@ -0,0 +1,180 @@
+/***************************************************************************
+                          ofx_transaction_record.cpp
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Implementation of OfxStringPool and OfxTransactionRecord
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cstddef>
+#include <cstring>
+#include "ofx_transaction_record.hh"
+
+/***************************************************************************
+ *                              OfxStringPool                              *
+ ***************************************************************************/
+
+OfxStringPool::OfxStringPool()
+{
+  strings.push_back(&ids.insert(make_pair(string(), 0u)).first->first);
+}
+
+unsigned int OfxStringPool::intern(const char *s, size_t length)
+{
+  if (length == 0)
+    return 0;
+  pair<unordered_map<string, unsigned int>::iterator, bool> inserted =
+    ids.insert(make_pair(string(s, length), (unsigned int)strings.size()));
+  if (inserted.second)
+  {
+    /* The keys of an unordered_map don't move when it grows */
+    strings.push_back(&inserted.first->first);
+  }
+  return inserted.first->second;
+}
+
+/***************************************************************************
+ *                          OfxTransactionRecord                           *
+ ***************************************************************************/
+
+struct StringField
+{
+  size_t offset;
+  size_t size;
+};
+
+#define STRING_FIELD(field) { offsetof(struct OfxTransactionData, field), sizeof(OfxTransactionData::field) }
+
+/** Every char array of OfxTransactionData */
+static const StringField string_fields[] =
+{
+  STRING_FIELD(account_id),
+  STRING_FIELD(fi_id),
+  STRING_FIELD(unique_id),
+  STRING_FIELD(unique_id_type),
+  STRING_FIELD(fi_id_corrected),
+  STRING_FIELD(server_transaction_id),
+  STRING_FIELD(check_number),
+  STRING_FIELD(reference_number),
+  STRING_FIELD(payee_id),
+  STRING_FIELD(name),
+  STRING_FIELD(memo),
+};
+
+static const size_t STRING_FIELD_COUNT = sizeof(string_fields) / sizeof(string_fields[0]);
+static const size_t WORD_SIZE = 8;
+static const size_t WORD_COUNT = (sizeof(struct OfxTransactionData) + WORD_SIZE - 1) / WORD_SIZE;
+static const size_t BITMAP_SIZE = (WORD_COUNT + 7) / 8;
+static const size_t ID_SIZE = sizeof(unsigned int);
+
+static_assert(STRING_FIELD_COUNT <= 16, "the string field mask is 16 bits");
+
+/** Length of a string field, which may fill it without a terminating 0 */
+static size_t field_length(const unsigned char *field, size_t size)
+{
+  const void *end = memchr(field, 0, size);
+  return end != NULL ? (const unsigned char *)end - field : size;
+}
+
+static bool is_zero(const unsigned char *word)
+{
+  for (size_t i = 0; i < WORD_SIZE; i++)
+  {
+    if (word[i] != 0)
+      return false;
+  }
+  return true;
+}
+
+OfxTransactionRecord::OfxTransactionRecord(const struct OfxTransactionData &data, OfxStringPool &pool)
+{
+  unsigned char image[WORD_COUNT * WORD_SIZE];
+  unsigned char buffer[2 + STRING_FIELD_COUNT * ID_SIZE + BITMAP_SIZE + sizeof(image)];
+  size_t length = 2;
+  unsigned int mask = 0;
+
+  memset(image, 0, sizeof(image));
+  memcpy(image, &data, sizeof(data));
+
+  /* Move the strings to the pool, leaving zeros in the image */
+  for (size_t i = 0; i < STRING_FIELD_COUNT; i++)
+  {
+    unsigned char *field = image + string_fields[i].offset;
+    size_t field_size = field_length(field, string_fields[i].size);
+    if (field_size > 0)
+    {
+      unsigned int id = pool.intern((const char *)field, field_size);
+      mask |= 1u << i;
+      memcpy(buffer + length, &id, ID_SIZE);
+      length += ID_SIZE;
+      memset(field, 0, string_fields[i].size);
+    }
+  }
+  buffer[0] = mask & 0xff;
+  buffer[1] = mask >> 8;
+
+  /* Then the words of the image that are not zero */
+  unsigned char *bitmap = buffer + length;
+  memset(bitmap, 0, BITMAP_SIZE);
+  length += BITMAP_SIZE;
+  for (size_t w = 0; w < WORD_COUNT; w++)
+  {
+    const unsigned char *word = image + w * WORD_SIZE;
+    if (!is_zero(word))
+    {
+      bitmap[w / 8] |= 1 << (w % 8);
+      memcpy(buffer + length, word, WORD_SIZE);
+      length += WORD_SIZE;
+    }
+  }
+  packed.assign(buffer, buffer + length);
+}
+
+void OfxTransactionRecord::restore(struct OfxTransactionData &data, const OfxStringPool &pool) const
+{
+  unsigned char image[WORD_COUNT * WORD_SIZE];
+  unsigned int ids[STRING_FIELD_COUNT];
+  const unsigned char *p = &packed[0];
+
+  unsigned int mask = p[0] | (p[1] << 8);
+  p += 2;
+  for (size_t i = 0; i < STRING_FIELD_COUNT; i++)
+  {
+    ids[i] = 0;
+    if (mask & (1u << i))
+    {
+      memcpy(&ids[i], p, ID_SIZE);
+      p += ID_SIZE;
+    }
+  }
+
+  const unsigned char *bitmap = p;
+  p += BITMAP_SIZE;
+  memset(image, 0, sizeof(image));
+  for (size_t w = 0; w < WORD_COUNT; w++)
+  {
+    if (bitmap[w / 8] & (1 << (w % 8)))
+    {
+      memcpy(image + w * WORD_SIZE, p, WORD_SIZE);
+      p += WORD_SIZE;
+    }
+  }
+
+  for (size_t i = 0; i < STRING_FIELD_COUNT; i++)
+  {
+    const string &s = pool.get(ids[i]);
+    memcpy(image + string_fields[i].offset, s.data(), s.size());
+  }
+  memcpy(&data, image, sizeof(data));
+}
@@ -0,0 +1,72 @@
+/***************************************************************************
+                          ofx_transaction_record.hh
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Compact storage of the transactions kept until the end of the file
+ *
+ * The OfxMainContainer generates the transaction events when the <OFX>
+ * element closes, so every transaction of the file is kept until then.
+ * An OfxTransactionData is about 1.5 KB, mostly fixed size strings and
+ * fields that are not valid; an OfxTransactionRecord only keeps what is
+ * set, with the strings interned in an OfxStringPool shared by the file,
+ * where payees, memos and account ids repeat a lot.
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef OFX_TRANSACTION_RECORD_H
+#define OFX_TRANSACTION_RECORD_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "libofx.h"
+
+using namespace std;
+
+/** \brief Stores each distinct string once, and identifies it by a number
+ *
+ The empty string is always number 0.
+ */
+class OfxStringPool
+{
+public:
+  OfxStringPool();
+  /** Returns the number of the string, adding it to the pool if it is new */
+  unsigned int intern(const char *s, size_t length);
+  const string &get(unsigned int id) const
+  {
+    return *strings[id];
+  };
+private:
+  unordered_map<string, unsigned int> ids;
+  vector<const string *> strings; /**< The keys of ids, by number */
+};
+
+/** \brief An OfxTransactionData, with its strings in an OfxStringPool and
+ * its zero bytes left out.
+ *
+ The record only depends on the layout of OfxTransactionData, and on
+ the list of its string fields in ofx_transaction_record.cpp, so it
+ follows the changes of the structure.
+ */
+class OfxTransactionRecord
+{
+public:
+  OfxTransactionRecord(const struct OfxTransactionData &data, OfxStringPool &pool);
+  /** Rebuilds the exact OfxTransactionData the record was made of */
+  void restore(struct OfxTransactionData &data, const OfxStringPool &pool) const;
+private:
+  /** A mask of the non empty string fields and their numbers in the pool,
+      a bitmap of the non zero 8 byte words of the rest of the structure,
+      and these words. */
+  vector<unsigned char> packed;
+};
+
+#endif
@@ -24,6 +24,7 @@
 #include <ctime>
 #include <cstdlib>
 #include <string>
+#include <mutex>
 #include <locale.h>
 #include "messages.hh"
 #include "ofx_utilities.hh"
@@ -67,32 +68,396 @@ using namespace std;
   return dest;
   }*/
 
-string CharStringtostring(const SGMLApplication::CharString source, string &dest)
+/**
+ * Append the code units of an OpenSP CharString to dest.
+ *
+ * OpenSP runs with a fixed single byte charset (see ofx_proc_file()), so code units up to 0xFF are the bytes of the file, already in the output encoding, and are copied as is.  Anything above can only come from a numeric character reference (&#8364;), and is encoded in UTF-8 rather than truncated.
+ *
+ * The common case is handled in blocks: a first loop checks that no code unit of the block exceeds 0xFF, a second one narrows it.  Neither loop has an early exit, so the compiler can turn both into SIMD code.
+ */
+static void append_charstring(const SGMLApplication::CharString &source, string &dest)
 {
-  size_t i;
-  dest.assign("");//Empty the provided string
-  //  cout<<"Length: "<<source.len<<"sizeof(Char)"<<sizeof(SGMLApplication::Char)<<endl;
-  for (i = 0; i < source.len; i++)
+  const size_t BLOCK = 64;
+  const SGMLApplication::Char *ptr = source.ptr;
+  const size_t len = source.len;
+  size_t i = 0;
+
+  dest.reserve(dest.size() + len);
+  while (i < len)
   {
-    dest += (char)(((source.ptr)[i]));
-    //    cout<<i<<" "<<(char)(((source.ptr)[i]))<<endl;
+    const size_t block_len = (len - i < BLOCK) ? len - i : BLOCK;
+    SGMLApplication::Char high_bits = 0;
+    for (size_t j = 0; j < block_len; j++)
+    {
+      high_bits |= ptr[i + j];
+    }
+    if (high_bits <= 0xFF)
+    {
+      char narrow[BLOCK];
+      for (size_t j = 0; j < block_len; j++)
+      {
+        narrow[j] = (char)ptr[i + j];
+      }
+      dest.append(narrow, block_len);
+    }
+    else
+    {
+      for (size_t j = 0; j < block_len; j++)
+      {
+        const unsigned long c = ptr[i + j];
+        if (c <= 0xFF)
+        {
+          dest += (char)c;
+        }
+        else if (c < 0x800)
+        {
+          dest += (char)(0xC0 | (c >> 6));
+          dest += (char)(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000)
+        {
+          dest += (char)(0xE0 | (c >> 12));
+          dest += (char)(0x80 | ((c >> 6) & 0x3F));
+          dest += (char)(0x80 | (c & 0x3F));
+        }
+        else
+        {
+          dest += (char)(0xF0 | ((c >> 18) & 0x07));
+          dest += (char)(0x80 | ((c >> 12) & 0x3F));
+          dest += (char)(0x80 | ((c >> 6) & 0x3F));
+          dest += (char)(0x80 | (c & 0x3F));
+        }
+      }
+    }
+    i += block_len;
   }
+}
+
+const string &CharStringtostring(const SGMLApplication::CharString source, string &dest)
+{
+  dest.clear();//Empty the provided string
+  append_charstring(source, dest);
   return dest;
 }
 
-string AppendCharStringtostring(const SGMLApplication::CharString source, string &dest)
+const string &AppendCharStringtostring(const SGMLApplication::CharString source, string &dest)
 {
-  size_t i;
-  for (i = 0; i < source.len; i++)
+  append_charstring(source, dest);
+  return dest;
+}
+
+OfxTimezoneCache::OfxTimezoneCache()
+  : tz_valid(false)
+  , tz_set(false)
+  , isdst(0)
+  , local_offset_time(0)
+  , local_offset_until(0)
+  , local_offset(0)
+  , generation(1)
+  , memo_hits(0)
+  , memo_misses(0)
+{
+  for (int i = 0; i < MEMO_SIZE; i++)
   {
-    dest += (char)(((source.ptr)[i]));
+    memo[i].value = 0;
+    memo[i].generation = 0;
   }
-  return dest;
+  invalidate_days();
+}
+
+void OfxTimezoneCache::invalidate_days()
+{
+  for (int i = 0; i < DAY_CACHE_SIZE; i++)
+    days[i].valid = false;
+}
+
+void OfxTimezoneCache::invalidate_memo()
+{
+  if (++generation == 0)
+  {
+    /* Wrapped around, entries from generation 1 would look fresh again */
+    for (int i = 0; i < MEMO_SIZE; i++)
+      memo[i].generation = 0;
+    generation = 1;
+  }
+}
+
+void OfxTimezoneCache::clear_memo()
+{
+  invalidate_memo();
+  memo_hits = 0;
+  memo_misses = 0;
+}
+
+/**
+ * Serializes the calls to the C library time functions: localtime() and gmtime() return a shared buffer, and the results of legacy_local_offset() and mktime() depend on the calls made just before.  The statements of a file may be parsed on several threads.
+ */
+static std::mutex time_functions_mutex;
+
+/**
+ * The local offset, computed exactly as earlier versions did for every date.
+ *
+ * localtime() and gmtime() share their result buffer, so this is not always the true UTC offset; it is kept as is so that converted dates don't change.
+ */
+static double legacy_local_offset(time_t now)
+{
+  return difftime(mktime(localtime(&now)), mktime(gmtime(&now)));
+}
+
+/// Number of days between 1970-01-01 and the given proleptic Gregorian date, month in [1, 12]
+static long long days_from_civil(long long y, unsigned int m, unsigned int d)
+{
+  y -= m <= 2;
+  const long long era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned int yoe = (unsigned int)(y - era * 400);
+  const unsigned int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const unsigned int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (long long)doe - 719468;
+}
+
+/**
+ * The UTC offset of the local time at t, times two, plus one if it is daylight saving time.  The time functions mutex must be held.
+ */
+static long long zone_state(time_t t)
+{
+  const struct tm *local = localtime(&t);
+  if (local == NULL)
+    return 0;
+  const long long local_seconds = days_from_civil(1900LL + local->tm_year, local->tm_mon + 1, local->tm_mday) * 86400LL
+                                  + local->tm_hour * 3600LL + local->tm_min * 60LL + local->tm_sec;
+  return (local_seconds - (long long)t) * 2 + (local->tm_isdst > 0);
+}
+
+/**
+ * Until when the local offset computed at now stays the same.  The time functions mutex must be held.
+ *
+ * legacy_local_offset() only depends on the time zone rules within a day of the time it is computed at.  The next change of the UTC offset or of DST is looked for a week at a time, up to a year ahead, and the offset is computed again a day before it.  Within a day of a change, it is computed again every minute.
+ */
+static time_t local_offset_until(time_t now)
+{
+  const time_t next_minute = now - now % 60 + 60;
+  const long long state = zone_state(now);
+  if (zone_state(now - 86400) != state)
+    return next_minute;
+
+  time_t unchanged = now;
+  time_t changed = 0;
+  for (int week = 1; week <= 53 && changed == 0; week++)
+  {
+    const time_t t = now + week * 7 * 86400;
+    if (zone_state(t) == state)
+      unchanged = t;
+    else
+      changed = t;
+  }
+  if (changed == 0)
+    return unchanged - 86400;
+  while (changed - unchanged > 1)
+  {
+    const time_t middle = unchanged + (changed - unchanged) / 2;
+    if (zone_state(middle) == state)
+      unchanged = middle;
+    else
+      changed = middle;
+  }
+  return changed - 86400 > now ? changed - 86400 : next_minute;
+}
+
+/**
+ * Reload the time zone part of the cache if TZ changed since it was filled, and refresh local_offset when the time zone rules change.
+ */
+static void refresh_timezone_cache(OfxTimezoneCache *cache)
+{
+  const char *tz = getenv("TZ");
+  if (!cache->tz_valid
+      || cache->tz_set != (tz != NULL)
+      || (tz != NULL && cache->tz != tz))
+  {
+    std::lock_guard<std::mutex> lock(time_functions_mutex);
+    tzset();
+    cache->tz_valid = true;
+    cache->tz_set = (tz != NULL);
+    cache->tz = (tz != NULL) ? tz : "";
+    cache->local_offset_time = 0;
+    cache->invalidate_days();
+    cache->invalidate_memo();
+  }
+
+  time_t now;
+  std::time(&now);
+  if (cache->local_offset_time == 0 || now >= cache->local_offset_until)
+  {
+    std::unique_lock<std::mutex> lock(time_functions_mutex);
+    const double offset = legacy_local_offset(now);
+    /* The C library updates daylight for the period of the last time it converted, which is now */
+    const int current_daylight = daylight;
+    const time_t until = local_offset_until(now);
+    lock.unlock();
+    if (cache->local_offset_time == 0 || cache->isdst != current_daylight)
+    {
+      cache->isdst = current_daylight;
+      cache->invalidate_days();
+      cache->invalidate_memo();
+    }
+    if (cache->local_offset != offset + (3600 * cache->isdst))
+    {
+      cache->local_offset = offset + (3600 * cache->isdst);
+      cache->invalidate_memo();
+    }
+    cache->local_offset_time = now;
+    cache->local_offset_until = until;
+  }
+}
+
+/// Decode count ASCII digits starting at ptr; the caller has already checked that they are digits
+static int decode_digits(const char *ptr, int count)
+{
+  int result = 0;
+  for (int i = 0; i < count; i++)
+  {
+    result = result * 10 + (ptr[i] - '0');
+  }
+  return result;
+}
+
+/**
+ * Sets up the C library as earlier versions did right before their mktime(), by computing the local offset again.  The time functions mutex must be held.
+ *
+ * When tm_isdst is forced to a value the zone doesn't use around that date, some C libraries resolve the time relative to the offset found by their previous call.  Replaying the local offset computation keeps the result independent of what was converted before.
+ */
+static void prime_mktime(OfxTimezoneCache *cache)
+{
+  legacy_local_offset(cache->local_offset_time);
+}
+
+/**
+ * Equivalent of mktime() with tm_isdst forced to the cached value, for fields that may be out of their normal range.
+ *
+ * The UTC offset of a local day is asked to mktime() once, at the first and last second of that day.  When both agree the day has no transition, the offset is remembered and every other time of that day is computed arithmetically, without taking the time functions mutex.  Days containing a transition always go through mktime().
+ */
+static time_t cached_mktime(OfxTimezoneCache *cache, int year, int mon, int mday, int hour, int min, int sec)
+{
+  /* Normalize the month the same way mktime() does before handing it to days_from_civil() */
+  long long y = 1900LL + year + mon / 12;
+  int m = mon % 12;
+  if (m < 0)
+  {
+    m += 12;
+    y--;
+  }
+  const long long local_seconds = (days_from_civil(y, m + 1, 1) + mday - 1) * 86400LL + hour * 3600LL + min * 60LL + sec;
+  long long local_day = local_seconds / 86400;
+  if (local_seconds % 86400 < 0)
+    local_day--;
+
+  OfxTimezoneCache::DayEntry &entry = cache->days[local_day & (OfxTimezoneCache::DAY_CACHE_SIZE - 1)];
+  if (entry.valid && entry.day == local_day)
+  {
+    return (time_t)(local_seconds - entry.offset);
+  }
+
+  struct tm time;
+  memset(&time, 0, sizeof(time));
+  time.tm_year = year;
+  time.tm_mon = mon;
+  time.tm_mday = mday;
+  time.tm_hour = hour;
+  time.tm_min = min;
+  time.tm_sec = sec;
+  time.tm_isdst = cache->isdst;
+  std::lock_guard<std::mutex> lock(time_functions_mutex);
+  prime_mktime(cache);
+  const time_t result = mktime(&time);
+  if (result == (time_t) - 1)
+    return result;
+
+  /* Probe both ends of the day before trusting the offset for all of it */
+  const long long offset = local_seconds - (long long)result;
+  for (int i = 0; i < 2; i++)
+  {
+    memset(&time, 0, sizeof(time));
+    time.tm_year = 70;
+    time.tm_mday = (int)local_day + 1;
+    time.tm_sec = i ? 86399 : 0;
+    time.tm_isdst = cache->isdst;
+    const time_t probe_result = mktime(&time);
+    if (probe_result == (time_t) - 1
+        || local_day * 86400 + (i ? 86399 : 0) - (long long)probe_result != offset)
+      return result;
+  }
+  entry.valid = true;
+  entry.day = local_day;
+  entry.offset = offset;
+  return result;
+}
+
+/**
+ * Does the actual work of ofxdate_to_time_t(), for a non empty string and a cache already refreshed.
+ * @param memoizable set to true if the string was well formed, so that converting it again without any warning is correct
+ */
+static time_t convert_ofxdate(const string &ofxdate, OfxTimezoneCache *cache, bool *memoizable)
+{
+  float ofx_gmt_offset; /* in fractional hours */
+  bool exact_time_specified = false;
+  int year, mon, mday;
+  int hour = 0, min = 0, sec = 0;
+
+  *memoizable = false;
+
+  const char *str = ofxdate.c_str();
+  string::size_type digits = 0;
+  while (digits < ofxdate.size() && str[digits] >= '0' && str[digits] <= '9')
+    digits++;
+
+  if (digits < 8)
+  {
+    /* Catch invalid string format */
+    message_out(ERROR, "ofxdate_to_time_t():  Unable to convert time, string " + ofxdate + " is not in proper YYYYMMDDHHMMSS.XXX[gmt offset:tz name] format!");
+    return 0;
+  }
+
+  year = decode_digits(str, 4) - 1900;
+  mon = decode_digits(str + 4, 2) - 1;
+  mday = decode_digits(str + 6, 2);
+  if (digits == 14)
+  {
+    /* if exact time is specified */
+    exact_time_specified = true;
+    hour = decode_digits(str + 8, 2);
+    min = decode_digits(str + 10, 2);
+    sec = decode_digits(str + 12, 2);
+  }
+  if (digits == 8 || digits == 14)
+  {
+    *memoizable = true;
+  }
+  else
+  {
+    message_out(WARNING, "ofxdate_to_time_t():  Successfully parsed date part, but unable to parse time part of string " + ofxdate.substr(0, digits) + ". It is not in proper YYYYMMDDHHMMSS.XXX[gmt offset:tz name] format!");
+  }
+
+  /* Check if the timezone has been specified */
+  string::size_type startidx = ofxdate.find('[');
+  if (startidx != string::npos)
+  {
+    /* If the timezone is specified always correct the timezone.  atof() stops at the ':' preceding the time zone name */
+    ofx_gmt_offset = atof(str + startidx + 1);
+    sec = sec + (int)(cache->local_offset - (ofx_gmt_offset * 60 * 60)); //Convert from fractionnal hours to seconds
+  }
+  else if (exact_time_specified == false)
+  {
+    /*Time zone data missing and exact time not specified, diverge from the OFX spec ans assume 11h59 local time */
+    hour = 11;
+    min = 59;
+    sec = 0;
+  }
+  return cached_mktime(cache, year, mon, mday, hour, min, sec);
 }
 
 /**
  * Converts a date from the YYYYMMDDHHMMSS.XXX[gmt offset:tz name] OFX format (see OFX 2.01 spec p.66) to a C time_t.
  * @param ofxdate date from the YYYYMMDDHHMMSS.XXX[gmt offset:tz name] OFX format
+ * @param cache time zone data kept between calls, normally the one of the current LibofxContext.  A process wide cache is used if NULL.
  * @return C time_t in the local time zone
  * @note
  * @li The library always returns the time in the systems local time
@@ -105,104 +470,50 @@ string AppendCharStringtostring(const SGMLApplication::CharString source, string
  * -When a timezone is specified, it is always used to properly convert in local time, following the spec.
  *
  */
-time_t ofxdate_to_time_t(const string ofxdate)
+time_t ofxdate_to_time_t(const string &ofxdate, OfxTimezoneCache *cache)
 {
-  struct tm time;
-  double local_offset; /* in seconds */
-  float ofx_gmt_offset; /* in fractional hours */
-  char timezone[4]; /* Original timezone: the library does not expose this value*/
-  char exact_time_specified = false;
-  char time_zone_specified = false;
-  string ofxdate_whole;
-  time_t temptime;
+  static OfxTimezoneCache default_cache;
+  bool memoizable;
 
-  time.tm_isdst = daylight; // initialize dst setting
-  std::time(&temptime);
-  local_offset = difftime(mktime(localtime(&temptime)), mktime(gmtime(&temptime))) + (3600 * daylight);
+  if (cache == NULL)
+    cache = &default_cache;
 
-  if (ofxdate.size() != 0)
+  if (ofxdate.size() == 0)
   {
-    ofxdate_whole = ofxdate.substr(0, ofxdate.find_first_not_of("0123456789"));
-    if (ofxdate_whole.size() >= 8)
-    {
-      time.tm_year = atoi(ofxdate_whole.substr(0, 4).c_str()) - 1900;
-      time.tm_mon = atoi(ofxdate_whole.substr(4, 2).c_str()) - 1;
-      time.tm_mday = atoi(ofxdate_whole.substr(6, 2).c_str());
-
-      if (ofxdate_whole.size() > 8)
-      {
-        if (ofxdate_whole.size() == 14)
-        {
-          /* if exact time is specified */
-          exact_time_specified = true;
-          time.tm_hour = atoi(ofxdate_whole.substr(8, 2).c_str());
-          time.tm_min = atoi(ofxdate_whole.substr(10, 2).c_str());
-          time.tm_sec = atoi(ofxdate_whole.substr(12, 2).c_str());
-        }
-        else
-        {
-          message_out(WARNING, "ofxdate_to_time_t():  Successfully parsed date part, but unable to parse time part of string " + ofxdate_whole + ". It is not in proper YYYYMMDDHHMMSS.XXX[gmt offset:tz name] format!");
-        }
-      }
-
-    }
-    else
-    {
-      /* Catch invalid string format */
-      message_out(ERROR, "ofxdate_to_time_t():  Unable to convert time, string " + ofxdate + " is not in proper YYYYMMDDHHMMSS.XXX[gmt offset:tz name] format!");
-      return mktime(&time);
-    }
-
+    message_out(ERROR, "ofxdate_to_time_t():  Unable to convert time, string is 0 length!");
+    return 0;
+  }
 
-    /* Check if the timezone has been specified */
-    string::size_type startidx = ofxdate.find("[");
-    string::size_type endidx;
-    if (startidx != string::npos)
-    {
-      /* Time zone was specified */
-      time_zone_specified = true;
-      startidx++;
-      endidx = ofxdate.find(":", startidx) - 1;
-      ofx_gmt_offset = atof(ofxdate.substr(startidx, (endidx - startidx) + 1).c_str());
-      startidx = endidx + 2;
-      strncpy(timezone, ofxdate.substr(startidx, 3).c_str(), 4);
-    }
-    else
-    {
-      /* Time zone was not specified, assume GMT (provisionnaly) in case exact time is specified */
-      ofx_gmt_offset = 0;
-      strcpy(timezone, "GMT");
-    }
+  refresh_timezone_cache(cache);
 
-    if (time_zone_specified == true)
-    {
-      /* If the timezone is specified always correct the timezone */
-      /* If the timezone is not specified, but the exact time is, correct the timezone, assuming GMT following the spec */
-      /* Correct the time for the timezone */
-      time.tm_sec = time.tm_sec + (int)(local_offset - (ofx_gmt_offset * 60 * 60)); //Convert from fractionnal hours to seconds
-    }
-    else if (exact_time_specified == false)
-    {
-      /*Time zone data missing and exact time not specified, diverge from the OFX spec ans assume 11h59 local time */
-      time.tm_hour = 11;
-      time.tm_min = 59;
-      time.tm_sec = 0;
-    }
-    return mktime(&time);
+  /* FNV-1a, the strings are short and mostly differ in their last few digits */
+  unsigned int hash = 2166136261U;
+  for (string::size_type i = 0; i < ofxdate.size(); i++)
+  {
+    hash = (hash ^ (unsigned char)ofxdate[i]) * 16777619U;
   }
-  else
+  OfxTimezoneCache::MemoEntry &entry = cache->memo[hash & (OfxTimezoneCache::MEMO_SIZE - 1)];
+  if (entry.generation == cache->generation && entry.date == ofxdate)
   {
-    message_out(ERROR, "ofxdate_to_time_t():  Unable to convert time, string is 0 length!");
-    return 0; // MUST RETURN ZERO here because otherwise the uninitialized &time will be returned!
+    cache->memo_hits++;
+    return entry.value;
+  }
+
+  cache->memo_misses++;
+  const time_t result = convert_ofxdate(ofxdate, cache, &memoizable);
+  if (memoizable)
+  {
+    entry.date = ofxdate;
+    entry.value = result;
+    entry.generation = cache->generation;
   }
-  return mktime(&time);
+  return result;
 }
 
 /**
- * Convert a C++ string containing an amount of money as specified by the OFX standard and convert it to a double float.
- *\note The ofx number format is the following:  "." or "," as decimal separator, NO thousands separator.
+ * The conversion done by versions up to 0.9.12, kept for the few amounts the fast path of ofxamount_to_double() can't convert exactly (more than 19 significant digits, huge exponents, "inf"...)
  */
-double ofxamount_to_double(const string ofxamount)
+static double legacy_ofxamount_to_double(const string &ofxamount)
 {
   //Replace commas and decimal points for atof()
   string::size_type idx;
@@ -222,43 +533,197 @@ double ofxamount_to_double(const string ofxamount)
   return atof(tmp.c_str());
 }
 
+/**
+ * Convert a C++ string containing an amount of money as specified by the OFX standard and convert it to a double float.
+ *\note The ofx number format is the following:  "." or "," as decimal separator, NO thousands separator.
+ *
+ * The first "." or "," following the integer part is taken as the decimal separator, whatever the locale, and parsing stops at the next character that can't be part of the number, like atof() does.  The result is correctly rounded: the mantissa and the power of ten are both exact doubles, so a single multiplication or division rounds once.
+ * @param ofxamount the amount as found in the file
+ * @param micros if not NULL, receives the amount in millionths, computed from the decimal digits (rounded half away from zero past the sixth decimal), not from the double.
+ */
+double ofxamount_to_double(const string &ofxamount, long long *micros)
+{
+  static const double powers_of_ten[] =
+  {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const char *ptr = ofxamount.c_str();
+  bool negative = false;
+  unsigned long long mantissa = 0;
+  int significant_digits = 0;
+  int exponent = 0; /* power of ten applied to mantissa */
+  bool any_digit = false;
+
+  while (*ptr == ' ' || (*ptr >= '\t' && *ptr <= '\r'))
+    ptr++;
+  if (*ptr == '-' || *ptr == '+')
+  {
+    negative = (*ptr == '-');
+    ptr++;
+  }
+
+  for (; *ptr >= '0' && *ptr <= '9'; ptr++)
+  {
+    any_digit = true;
+    if (significant_digits < 19)
+    {
+      mantissa = mantissa * 10 + (*ptr - '0');
+      if (mantissa != 0)
+        significant_digits++;
+    }
+    else
+    {
+      significant_digits++;
+    }
+  }
+  if (*ptr == '.' || *ptr == ',')
+  {
+    for (ptr++; *ptr >= '0' && *ptr <= '9'; ptr++)
+    {
+      any_digit = true;
+      if (significant_digits < 19)
+      {
+        mantissa = mantissa * 10 + (*ptr - '0');
+        exponent--;
+        if (mantissa != 0)
+          significant_digits++;
+      }
+      else if (*ptr != '0')
+      {
+        significant_digits++; /* Can't be dropped without changing the value */
+      }
+    }
+  }
+  if (any_digit && (*ptr == 'e' || *ptr == 'E'))
+  {
+    const char *exp_ptr = ptr + 1;
+    bool exp_negative = false;
+    int exp_value = 0;
+    if (*exp_ptr == '-' || *exp_ptr == '+')
+    {
+      exp_negative = (*exp_ptr == '-');
+      exp_ptr++;
+    }
+    if (*exp_ptr >= '0' && *exp_ptr <= '9')
+    {
+      for (; *exp_ptr >= '0' && *exp_ptr <= '9'; exp_ptr++)
+      {
+        if (exp_value < 10000)
+          exp_value = exp_value * 10 + (*exp_ptr - '0');
+      }
+      exponent += exp_negative ? -exp_value : exp_value;
+    }
+  }
+
+  if (!any_digit || significant_digits > 19 || *ptr == 'x' || *ptr == 'X')
+  {
+    /* Not a plain decimal number, or too many digits to be held exactly */
+    const double result = legacy_ofxamount_to_double(ofxamount);
+    if (micros != NULL)
+    {
+      const double scaled = result * 1e6;
+      if (scaled > -9.2e18 && scaled < 9.2e18)
+        *micros = (long long)(scaled + (scaled < 0 ? -0.5 : 0.5));
+      else
+        *micros = 0;
+    }
+    return result;
+  }
+
+  if (micros != NULL)
+  {
+    const int scale = exponent + 6;
+    unsigned long long value = mantissa;
+    if (scale >= 0)
+    {
+      for (int i = 0; i < scale && value != 0; i++)
+      {
+        if (value > 922337203685477580ULL)
+        {
+          value = 0; /* Doesn't fit, same as a non numeric amount */
+          break;
+        }
+        value *= 10;
+      }
+    }
+    else if (scale < -19)
+    {
+      value = 0;
+    }
+    else
+    {
+      unsigned long long divisor = 1;
+      for (int i = 0; i < -scale; i++)
+        divisor *= 10;
+      const unsigned long long remainder = value % divisor;
+      value = value / divisor + (remainder >= divisor - remainder ? 1 : 0);
+    }
+    if (value > 9223372036854775807ULL)
+      value = 0;
+    *micros = negative ? -(long long)value : (long long)value;
+  }
+
+  if (mantissa == 0)
+  {
+    return negative ? -0.0 : 0.0;
+  }
+  else if (mantissa < (1ULL << 53) && exponent >= -22 && exponent <= 22)
+  {
+    double result = (double)mantissa;
+    if (exponent < 0)
+      result /= powers_of_ten[-exponent];
+    else
+      result *= powers_of_ten[exponent];
+    return negative ? -result : result;
+  }
+  return legacy_ofxamount_to_double(ofxamount);
+}
+
+/// Whether c is one of " \b\f\n\r\t\v"
+static inline bool is_ofx_whitespace(char c)
+{
+  return c == ' ' || c == '\b' || (c >= '\t' && c <= '\r');
+}
+
 /**
 Many weird caracters can be present inside a SGML element, as a result on the transfer protocol, or for any reason.  This function greatly enhances the reliability of the library by zapping those gremlins (backspace,formfeed,newline,carriage return, horizontal and vertical tabs) as well as removing whitespace at the begining and end of the string.  Otherwise, many problems will occur during stringmatching.
+
+The string is trimmed and compacted in place, in a single pass, without any allocation.
 */
-string strip_whitespace(const string para_string)
+void strip_whitespace(string &para_string)
 {
-  size_t index;
-  size_t i;
-  string temp_string = para_string;
-  if (temp_string.empty())
-    return temp_string; // so that size()-1 is allowed below
-
-  const char *whitespace = " \b\f\n\r\t\v";
-  const char *abnormal_whitespace = "\b\f\n\r\t\v";//backspace,formfeed,newline,cariage return, horizontal and vertical tabs
-  message_out(DEBUG4, "strip_whitespace() Before: |" + temp_string + "|");
-
-  for (i = 0;
-       i <= temp_string.size()
-       && temp_string.find_first_of(whitespace, i) == i
-       && temp_string.find_first_of(whitespace, i) != string::npos;
-       i++);
-  temp_string.erase(0, i); //Strip leading whitespace
-
-  for (i = temp_string.size() - 1;
-       (i > 0)
-       && (temp_string.find_last_of(whitespace, i) == i)
-       && (temp_string.find_last_of(whitespace, i) != string::npos);
-       i--);
-  temp_string.erase(i + 1, temp_string.size() - (i + 1)); //Strip trailing whitespace
-
-  while ((index = temp_string.find_first_of(abnormal_whitespace)) != string::npos)
-  {
-    temp_string.erase(index, 1); //Strip leading whitespace
-  };
+  if (para_string.empty())
+    return;
+
+  message_out(DEBUG4, "strip_whitespace() Before: |" + para_string + "|");
+
+  const string::size_type size = para_string.size();
+  string::size_type read = 0;
+  string::size_type write = 0;
+  string::size_type end = 0; /* just past the last character that isn't whitespace */
 
-  message_out(DEBUG4, "strip_whitespace() After:  |" + temp_string + "|");
+  /* Strip leading whitespace */
+  while (read < size && is_ofx_whitespace(para_string[read]))
+    read++;
+
+  for (; read < size; read++)
+  {
+    const char c = para_string[read];
+    if (c == ' ')
+    {
+      para_string[write++] = c;
+    }
+    else if (!is_ofx_whitespace(c))
+    {
+      para_string[write++] = c;
+      end = write;
+    }
+    /* Other whitespace (backspace,formfeed,newline,cariage return, horizontal and vertical tabs) is dropped */
+  }
+  para_string.resize(end); //Strip trailing whitespace
 
-  return temp_string;
+  message_out(DEBUG4, "strip_whitespace() After:  |" + para_string + "|");
 }
 
 
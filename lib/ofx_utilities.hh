@@ -19,6 +19,7 @@
 #define OFX_UTIL_H
 #include <string.h>
 #include <time.h>		// for time_t
+#include <string>
 #include "ParserEventGeneratorKit.h"
 using namespace std;
 /* This file contains various simple functions for type conversion & al */
@@ -32,19 +33,76 @@ ostream &operator<<(ostream &os, SGMLApplication::CharString s);
 wchar_t* CharStringtowchar_t(SGMLApplication::CharString source, wchar_t *dest);
 
 ///Convert OpenSP CharString to a C++ STL string
-string CharStringtostring(const SGMLApplication::CharString source, string &dest);
+const string &CharStringtostring(const SGMLApplication::CharString source, string &dest);
 
 ///Append an OpenSP CharString to an existing C++ STL string
-string AppendCharStringtostring(const SGMLApplication::CharString source, string &dest);
+const string &AppendCharStringtostring(const SGMLApplication::CharString source, string &dest);
+
+/**
+ * \brief Time zone data and converted dates cached between calls to ofxdate_to_time_t()
+ *
+ * Computing the local offset and asking mktime() for the UTC offset of a
+ * given day is by far the most expensive part of date conversion.  This
+ * cache remembers the local offset until the next change of the time zone
+ * rules, and the UTC offsets of the last local days converted in a small
+ * direct mapped table.  It is invalidated whenever the TZ environment
+ * variable changes.  Each LibofxContext owns one.
+ *
+ * In front of that, a small direct mapped table remembers the last date
+ * strings converted, since all the transactions of a posting day usually
+ * carry the very same DTPOSTED.
+ */
+struct OfxTimezoneCache
+{
+  OfxTimezoneCache();
+
+  /** Forget the converted dates and zero the hit/miss counters, at the start of each parse */
+  void clear_memo();
+  /** Forget the converted dates, when the time zone data they were computed with changed */
+  void invalidate_memo();
+
+  bool tz_valid; /**< false until the time zone has been loaded once */
+  bool tz_set; /**< whether TZ was set in the environment */
+  string tz; /**< value of TZ when the cache was filled */
+  int isdst; /**< tm_isdst forced on converted dates: the C library's daylight for the current period */
+
+  time_t local_offset_time; /**< time local_offset was computed at */
+  time_t local_offset_until; /**< local_offset stays the same until then, unless TZ changes */
+  double local_offset; /**< offset applied to dates with an explicit time zone, in seconds */
+
+  /** Forget the UTC offsets of the local days, when the time zone data changed */
+  void invalidate_days();
+
+  enum { DAY_CACHE_SIZE = 64 /**< number of local days remembered, a power of 2 */ };
+  struct DayEntry
+  {
+    bool valid; /**< whether day and offset hold a usable entry */
+    long long day; /**< local day number (days since 1970-01-01) */
+    long long offset; /**< local time minus UTC for the whole of that day, in seconds */
+  };
+  DayEntry days[DAY_CACHE_SIZE];
+
+  enum { MEMO_SIZE = 64 /**< number of date strings remembered, a power of 2 */ };
+  struct MemoEntry
+  {
+    string date; /**< date string as found in the file */
+    time_t value; /**< what ofxdate_to_time_t() returned for it */
+    unsigned int generation; /**< generation the entry was stored in, 0 if unused */
+  };
+  MemoEntry memo[MEMO_SIZE];
+  unsigned int generation; /**< bumped whenever the entries above become stale */
+  unsigned long memo_hits; /**< conversions answered from memo since the last clear_memo() */
+  unsigned long memo_misses; /**< conversions actually computed since the last clear_memo() */
+};
 
 ///Convert a C++ string containing a time in OFX format to a C time_t
-time_t ofxdate_to_time_t(const string ofxdate);
+time_t ofxdate_to_time_t(const string &ofxdate, OfxTimezoneCache *cache = NULL);
 
-///Convert OFX amount of money to double float
-double ofxamount_to_double(const string ofxamount);
+///Convert OFX amount of money to double float, and optionally to an exact number of millionths
+double ofxamount_to_double(const string &ofxamount, long long *micros = NULL);
 
-///Sanitize a string coming from OpenSP
-string strip_whitespace(const string para_string);
+///Sanitize a string coming from OpenSP, in place
+void strip_whitespace(string &para_string);
 
 int mkTempFileName(const char *tmpl, char *buffer, unsigned int size);
 
@@ -0,0 +1,60 @@
+/***************************************************************************
+                          probes.hh
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Static tracepoints (USDT) for tracing tools
+ *
+ When configured on a system with <sys/sdt.h> (systemtap-sdt-dev or
+ systemtap-sdt-devel), the library contains the following probes of the
+ "libofx" provider, usable with bpftrace, perf or systemtap.  Each costs a
+ single nop when not traced.  Otherwise, or with --disable-sdt-probes,
+ they are compiled out.
+
+ - parse-start(const char *filename, int file_type),
+   parse-end(const char *filename): libofx_proc_file()
+ - phase-start(const char *phase), phase-end(const char *phase): "detect",
+   "headers", "sanitize", "iconv", "dtd" and "sgml", the phases of
+   libofx_proc_file() and ofx_proc_file().  "sanitize" and "iconv" fire
+   once per line, inside "headers".
+ - element-start(const char *name), element-end(const char *name): OpenSP
+   start and end of element events, except inside skipped aggregates
+ - callback-start(const char *callback),
+   callback-end(const char *callback, int retval): "status", "account",
+   "security", "transaction" and "statement" callbacks of the application
+ - gen-event-start(), gen-event-end(): OfxMainContainer::gen_event()
+
+ For example, the time spent in the transaction callbacks:
+ \code
+ bpftrace -e 'usdt:/usr/lib/libofx.so:libofx:callback-start { @s[tid] = nsecs; }
+   usdt:/usr/lib/libofx.so:libofx:callback-end /@s[tid]/ {
+     @ns[str(arg0)] = hist(nsecs - @s[tid]); delete(@s[tid]); }'
+ \endcode
+*/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef PROBES_H
+#define PROBES_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define OFX_PROBE(name) DTRACE_PROBE(libofx, name)
+#define OFX_PROBE1(name, arg1) DTRACE_PROBE1(libofx, name, arg1)
+#define OFX_PROBE2(name, arg1, arg2) DTRACE_PROBE2(libofx, name, arg1, arg2)
+#else
+#define OFX_PROBE(name) do { } while (0)
+#define OFX_PROBE1(name, arg1) do { } while (0)
+#define OFX_PROBE2(name, arg1, arg2) do { } while (0)
+#endif
+
+#endif
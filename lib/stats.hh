@@ -0,0 +1,72 @@
+/***************************************************************************
+                          stats.hh
+                             -------------------
+ ***************************************************************************/
+/**@file
+ * \brief Timing of the processing phases, see libofx_get_stats()
+ */
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include "libofx.h"
+
+/** Monotonic time, in nanoseconds */
+inline unsigned long long stats_now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * \brief Adds the time elapsed between its construction and its
+ * destruction to a LibofxStats counter.
+ */
+class OfxStatsTimer
+{
+public:
+  OfxStatsTimer(unsigned long long &counter)
+    : _counter(counter)
+    , _start(stats_now_ns())
+  {
+  };
+  ~OfxStatsTimer()
+  {
+    _counter += stats_now_ns() - _start;
+  };
+private:
+  unsigned long long &_counter;
+  unsigned long long _start;
+};
+
+/** Adds the statistics of the context of another thread to total */
+inline void add_stats(struct LibofxStats &total, const struct LibofxStats &stats)
+{
+  total.file_detection_ns += stats.file_detection_ns;
+  total.header_parsing_ns += stats.header_parsing_ns;
+  total.iconv_ns += stats.iconv_ns;
+  total.sanitize_ns += stats.sanitize_ns;
+  total.dtd_ns += stats.dtd_ns;
+  total.sgml_parsing_ns += stats.sgml_parsing_ns;
+  total.container_ns += stats.container_ns;
+  total.callback_ns += stats.callback_ns;
+  total.bytes_read += stats.bytes_read;
+  total.elements += stats.elements;
+  total.data_elements += stats.data_elements;
+  total.dummy_containers += stats.dummy_containers;
+  total.transactions += stats.transactions;
+  total.securities += stats.securities;
+  total.allocations += stats.allocations;
+  total.date_cache_hits += stats.date_cache_hits;
+  total.date_cache_misses += stats.date_cache_misses;
+}
+
+#endif